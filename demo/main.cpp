@@ -35,11 +35,14 @@
    // Pipelines:
    Eng::PipelineDefault dfltPipe;
    Eng::PipelineOIT oitPipe;
+   Eng::PipelineHiZ hizPipe;
+   Eng::PipelineSortedAlpha alphaPipe;
    Eng::PipelineFullscreen2D full2dPipe;
 
    // Flags:
    bool showShadowMap = false;
    bool perspectiveProj = false;
+   bool useOIT = true;
 
 
 
@@ -116,6 +119,8 @@ void keyboardCallback(int key, int scancode, int action, int mods)
    {
       case 'W': if (action == 0) oitPipe.setWireframe(!oitPipe.isWireframe()); break;         
       case 'S': if (action == 0) showShadowMap = !showShadowMap; break;
+      case 'O': if (action == 0) useOIT = !useOIT; break;
+      case 'M': if (action == 0) Eng::Managed::dumpReport(); break;
    }
 }
 
@@ -155,16 +160,17 @@ int main(int argc, char *argv[])
    std::cout << "Scene graph:\n" << root.getTreeAsString() << std::endl;
    
    // Get torus knot ref:
-   //Eng::Mesh &tknot = dynamic_cast<Eng::Mesh &>(Eng::Container::getInstance().find("Torus Knot001"));   
+   //Eng::Mesh &tknot = Eng::Container::getInstance().find<Eng::Mesh>("Torus Knot001");   
 
-   Eng::Light &omni001=dynamic_cast<Eng::Light &>(Eng::Container::getInstance().find("Omni001"));
-   Eng::Light &omni002=dynamic_cast<Eng::Light &>(Eng::Container::getInstance().find("Omni002"));
+   Eng::Light &omni001 = Eng::Container::getInstance().find<Eng::Light>("Omni001");
+   Eng::Light &omni002 = Eng::Container::getInstance().find<Eng::Light>("Omni002");
 
    omni001.setColor(glm::vec3(1.0f, 0.0f, 0.0f));
    omni002.setColor(glm::vec3(0.0f, 1.0f, 0.0f));
 
-   // Rendering elements:
+   // Rendering elements (kept in sync with the scene graph):
    Eng::List list;      
+   list.process(root);
    
    // Init camera:   
    camera.setProjMatrix(glm::perspective(glm::radians(45.0f), eng.getWindowSize().x / (float) eng.getWindowSize().y, 1.0f, 1000.0f));
@@ -188,13 +194,18 @@ int main(int argc, char *argv[])
       //tknot.setMatrix(glm::rotate(tknot.getMatrix(), glm::radians(15.0f * fpsFactor), glm::vec3(0.0f, 1.0f, 0.0f)));
       
       // Update list:
-      list.reset();
-      list.process(root);
+      list.update();
+      list.selectLods(camera);
+      hizPipe.cull(list);
       
       // Main rendering:
       eng.clear();      
          dfltPipe.render(camera, list);
-         oitPipe.render(camera, list);
+         hizPipe.render(camera, list);
+         if (useOIT)
+            oitPipe.render(camera, list);
+         else
+            alphaPipe.render(camera, list);
        //  eng.clear();    
        //  full2dPipe.render(oitPipe.getRenderTexture(), list);
 
@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM core
+
    // Main include:
    #include "engine.h"
 
@@ -20,6 +23,8 @@
 
    // C/C++:
    #include <sstream>   
+   #include <thread>
+   #include <mutex>
 
    
 
@@ -41,6 +46,11 @@ struct Eng::Base::Reserved
    // Compatibility flags:
    bool bindlessSupportFlag;           ///< When true, the current context supports ARB_bindless_texture
 
+   // Context thread:
+   std::thread::id contextThread;      ///< Thread owning the OpenGL context
+   std::mutex taskMutex;               ///< Guards the task queue
+   std::vector<std::function<void()>> tasks;   ///< GL work queued by other threads
+
    // Callbacks:
    Eng::Base::KeyboardCallback keyboardCallback;
    Eng::Base::MouseCursorCallback mouseCursorCallback;
@@ -238,6 +248,7 @@ bool ENG_API Eng::Base::init()
 
    // Set context:
    glfwMakeContextCurrent(reserved->window);
+   reserved->contextThread = std::this_thread::get_id();
 
    // Glew:   
    GLenum err = glewInit();
@@ -345,7 +356,10 @@ bool ENG_API Eng::Base::free()
 {
    ENG_LOG_DEBUG("Releasing context...");
 
-   // Since the context is about to be released, unload all objects that are still allocated:
+   // Run pending uploads, then unload all objects that are still allocated since the context is about to be released:
+   if (reserved->window)
+      processTasks();
+   Mesh::freeSharedResources();
    Managed::forceRelease();
 
    // Release glfw:
@@ -361,6 +375,12 @@ bool ENG_API Eng::Base::free()
 
    ENG_LOG_PLAIN("   Context deinitialized");
 
+   // Join the job workers while the engine is still loaded (further jobs run on the waiting threads):
+   Jobs::getInstance().free();
+
+   // Stop the log writer thread while the engine is still loaded (further messages are written synchronously):
+   Log::setAsynchronous(false);
+
    // Done:
    return true;
 }
@@ -407,6 +427,8 @@ bool ENG_API Eng::Base::clear()
 bool ENG_API Eng::Base::swap()
 {
    // ENG_LOG_DEBUG("Finished with frame %llu", reserved->frameCounter);
+   processTasks();
+   Managed::endFrame();
    glfwSwapBuffers(reserved->window);
 
    // New frame:
@@ -551,4 +573,82 @@ bool ENG_API Eng::Base::setMouseScrollCallback(MouseScrollCallback cb)
 bool ENG_API Eng::Base::isBindlessSupported() const
 { 
    return reserved->bindlessSupportFlag;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Tells whether the caller runs on the thread owning the OpenGL context.
+ * @return TF
+ */
+bool ENG_API Eng::Base::isContextThread() const
+{
+   return std::this_thread::get_id() == reserved->contextThread;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Schedules work requiring the OpenGL context. Tasks submitted from the context thread run immediately, tasks from 
+ * any other thread are queued and executed by the next processTasks() (called at each swap()). Tasks are discarded
+ * when no context has been created.
+ * @param task function to execute on the context thread
+ */
+void ENG_API Eng::Base::enqueue(std::function<void()> task)
+{
+   // Safety net:
+   if (!task)
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return;
+   }
+
+   if (isContextThread())
+   {
+      task();
+      return;
+   }
+
+   // No context at all (e.g., offline tools loading scenes), so nothing to upload to:
+   if (reserved->contextThread == std::thread::id())
+      return;
+
+   std::lock_guard<std::mutex> lock(reserved->taskMutex);
+   reserved->tasks.push_back(std::move(task));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Executes the tasks queued by other threads. Must be called from the context thread.
+ * @return number of executed tasks
+ */
+uint32_t ENG_API Eng::Base::processTasks()
+{
+   // Safety net:
+   if (!isContextThread())
+   {
+      ENG_LOG_ERROR("Tasks must be processed on the context thread");
+      return 0;
+   }
+
+   // Tasks may enqueue further tasks, so the queue is swapped out before running them:
+   uint32_t nrOfTasks = 0;
+   while (true)
+   {
+      std::vector<std::function<void()>> pending;
+      {
+         std::lock_guard<std::mutex> lock(reserved->taskMutex);
+         pending.swap(reserved->tasks);
+      }
+      if (pending.empty())
+         break;
+
+      for (auto &task : pending)
+         task();
+      nrOfTasks += (uint32_t) pending.size();
+   }
+
+   // Done:
+   return nrOfTasks;
 }
\ No newline at end of file
@@ -18,6 +18,12 @@
    #include <vector>
    #include <list>   
    #include <memory> 
+   #include <new>
+   #include <atomic>
+   #include <functional>
+   #include <tuple>
+   #include <cstring>
+   #include <type_traits>
 
    // GLM:
 #ifndef _DEBUG
@@ -72,6 +78,12 @@ namespace Eng {
    // Logging:
    #include "engine_log.h"
 
+   // Memory:
+   #include "engine_pool.h"
+
+   // Threading:
+   #include "engine_jobs.h"
+
    // Architecture:
    #include "engine_object.h"
    #include "engine_managed.h"
@@ -104,6 +116,8 @@ namespace Eng {
    // Pipelines:
    #include "engine_pipeline.h"
    #include "engine_pipeline_shadowmapping.h"
+   #include "engine_pipeline_hiz.h"
+   #include "engine_pipeline_sortedalpha.h"
    #include "engine_pipeline_fullscreen2d.h"
    #include "engine_pipeline_default.h"
    
@@ -159,6 +173,11 @@ public: //
    bool setMouseButtonCallback(MouseButtonCallback cb);
    bool setMouseScrollCallback(MouseScrollCallback cb);
 
+   // Context thread:
+   bool isContextThread() const;
+   void enqueue(std::function<void()> task);
+   uint32_t processTasks();
+
    // Compatibility:
    bool isBindlessSupported() const;
 
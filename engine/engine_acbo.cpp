@@ -1,4 +1,7 @@
-﻿#include "engine.h"
+﻿// Logging subsystem:
+#define ENG_LOG_SUBSYSTEM resource
+
+#include "engine.h"
 #include "engine_acbo.h"
 
 // OGL:      
@@ -79,6 +82,7 @@ bool Eng::Acbo::create(uint32_t size, void* data, uint32_t usage)
 {
     glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, reserved->oglId);
     glBufferData(GL_ATOMIC_COUNTER_BUFFER, size, data, usage);
+    this->setMemoryUsage(MemoryType::atomicCounterBuffer, size);
     return true;
 }
 
@@ -86,6 +90,7 @@ bool Eng::Acbo::create()
 {
     glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, reserved->oglId);
     glBufferData(GL_ATOMIC_COUNTER_BUFFER, sizeof(GLuint), NULL, GL_DYNAMIC_DRAW);
+    this->setMemoryUsage(MemoryType::atomicCounterBuffer, sizeof(GLuint));
     return true;
 }
 
@@ -98,7 +103,7 @@ bool ENG_API Eng::Acbo::init()
     // Free buffer if already stored:
     if (reserved->oglId)
     {
-        glDeleteBuffers(1, &reserved->oglId);
+        Eng::Managed::release(Eng::Managed::Resource::buffer, reserved->oglId);
         reserved->oglId = 0;
     }
 
@@ -123,7 +128,7 @@ bool ENG_API Eng::Acbo::free()
     // Free VAO if stored:
     if (reserved->oglId)
     {
-        glDeleteBuffers(1, &reserved->oglId);
+        Eng::Managed::release(Eng::Managed::Resource::buffer, reserved->oglId);
         reserved->oglId = 0;
     }
 
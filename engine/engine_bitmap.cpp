@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM texture
+
    // Main include:
    #include "engine.h"
 
@@ -63,6 +66,10 @@ struct Eng::Bitmap::Reserved
    float compressionFactor;         ///< Compression factor
 
 
+   // Allocated from a pool:
+   ENG_POOLED(Reserved)
+
+
    /**
     * Constructor. 
     */
@@ -195,8 +202,12 @@ uint32_t ENG_API Eng::Bitmap::getColorDepth() const
 
       case Format::r8g8b8a8:
       case Format::r8g8b8a8_compressed:
+      case Format::r8g8b8a8_bptc:
          return 4;
 
+      case Format::r16g16b16f_bptc:
+         return 6;
+
       default:
          ENG_LOG_ERROR("Invalid value");
          return 0;
@@ -425,10 +436,10 @@ bool ENG_API Eng::Bitmap::load(const std::string &filename)
       if (strcmp(fourCC, "DXT5") == 0)      
          reserved->format = Eng::Bitmap::Format::r8g8b8a8_compressed;         
       else
-         if (strcmp(fourCC, "ATI1") == 0)         
+         if (strcmp(fourCC, "ATI1") == 0 || strcmp(fourCC, "BC4U") == 0)         
             reserved->format = Eng::Bitmap::Format::r8_compressed;            
          else
-            if (strcmp(fourCC, "ATI2") == 0)            
+            if (strcmp(fourCC, "ATI2") == 0 || strcmp(fourCC, "BC5U") == 0)            
                reserved->format = Eng::Bitmap::Format::r8g8_compressed;                           
             else
                if (strcmp(fourCC, "DX10") == 0)
@@ -455,6 +466,22 @@ bool ENG_API Eng::Bitmap::load(const std::string &filename)
                         reserved->format = Eng::Bitmap::Format::r8g8b8a8_compressed;                        
                         break;
 
+                     case DXGI_FORMAT_BC4_UNORM:
+                        reserved->format = Eng::Bitmap::Format::r8_compressed;
+                        break;
+
+                     case DXGI_FORMAT_BC5_UNORM:
+                        reserved->format = Eng::Bitmap::Format::r8g8_compressed;
+                        break;
+
+                     case DXGI_FORMAT_BC6H_UF16:
+                        reserved->format = Eng::Bitmap::Format::r16g16b16f_bptc;
+                        break;
+
+                     case DXGI_FORMAT_BC7_UNORM:
+                        reserved->format = Eng::Bitmap::Format::r8g8b8a8_bptc;
+                        break;
+
                      default:
                         ENG_LOG_ERROR("File '%s' uses an unsupported DX10 compression format", filename.c_str());                                                
                         return false;
@@ -472,6 +499,8 @@ bool ENG_API Eng::Bitmap::load(const std::string &filename)
       case Eng::Bitmap::Format::r8g8_compressed:       reserved->compressionFactor = 1.0f; break;
       case Eng::Bitmap::Format::r8g8b8_compressed:     reserved->compressionFactor = 0.5f; break;
       case Eng::Bitmap::Format::r8g8b8a8_compressed:   reserved->compressionFactor = 1.0f; break;
+      case Eng::Bitmap::Format::r8g8b8a8_bptc:         reserved->compressionFactor = 1.0f; break;
+      case Eng::Bitmap::Format::r16g16b16f_bptc:       reserved->compressionFactor = 1.0f; break;
    }
 
    // Allocate and populate layers:   
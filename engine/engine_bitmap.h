@@ -38,6 +38,10 @@ public: //
       r8g8_compressed,
       r8_compressed,
 
+      // Compressed (BPTC):
+      r8g8b8a8_bptc,          ///< BC7
+      r16g16b16f_bptc,        ///< BC6H (unsigned)
+
       // Terminator:
       last
    };
@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM scene
+
    // Main include:
    #include "engine.h"
 
@@ -55,6 +58,10 @@ struct Eng::Camera::Reserved
    std::reference_wrapper<const Eng::Node> target; /// Center around this target
 
 
+   // Allocated from a pool:
+   ENG_POOLED(Reserved)
+
+
    /**
     * Constructor
     */
@@ -11,12 +11,18 @@
 // #INCLUDE //
 //////////////
 
-    // Main include:
+    // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM core
+
+   // Main include:
    #include "engine.h"
 
    // C/C++:
    #include <algorithm>
    #include <variant>
+   #include <unordered_map>
+   #include <shared_mutex>
+   #include <mutex>
 
 
 
@@ -38,13 +44,20 @@
  */
 struct Eng::Container::Reserved
 {
-   std::list<Eng::Node> allNodes;
-   std::list<Eng::Mesh> allMeshes;
-   std::list<Eng::Camera> allCameras;
-   std::list<Eng::Light> allLights;
-   std::list<Eng::Bitmap> allBitmaps;
-   std::list<Eng::Material> allMaterials;
-   std::list<Eng::Texture> allTextures;
+   Eng::PooledList<Eng::Node> allNodes;
+   Eng::PooledList<Eng::Mesh> allMeshes;
+   Eng::PooledList<Eng::Camera> allCameras;
+   Eng::PooledList<Eng::Light> allLights;
+   Eng::PooledList<Eng::Bitmap> allBitmaps;
+   Eng::PooledList<Eng::Material> allMaterials;
+   Eng::PooledList<Eng::Texture> allTextures;
+
+   // Indices:
+   std::unordered_map<std::string, std::vector<Eng::Object *>> byName;   ///< Objects sorted by search priority
+   std::unordered_map<uint32_t, Eng::Object *> byId;
+
+   // Objects can be added and looked up by any thread:
+   std::shared_mutex mutex;
    
 
    /**
@@ -52,6 +65,40 @@ struct Eng::Container::Reserved
     */
    Reserved()
    {}
+
+
+   /**
+    * Gets the search priority of an object, matching the order followed by the original list scans
+    * (materials, textures, meshes, cameras, lights, nodes, bitmaps).
+    * @param obj object
+    * @return priority (lower first)
+    */
+   static uint32_t getPriority(const Eng::Object &obj)
+   {
+      if (dynamic_cast<const Eng::Material *>(&obj)) return 0;
+      if (dynamic_cast<const Eng::Texture *>(&obj)) return 1;
+      if (dynamic_cast<const Eng::Mesh *>(&obj)) return 2;
+      if (dynamic_cast<const Eng::Camera *>(&obj)) return 3;
+      if (dynamic_cast<const Eng::Light *>(&obj)) return 4;
+      if (dynamic_cast<const Eng::Node *>(&obj)) return 5;
+      return 6;
+   }
+
+
+   /**
+    * Adds an object (already stored in its list) to the indices.
+    * @param obj object
+    */
+   void index(Eng::Object &obj)
+   {
+      byId[obj.getId()] = &obj;
+
+      std::vector<Eng::Object *> &entries = byName[obj.getName()];
+      const uint32_t priority = getPriority(obj);
+      auto it = std::upper_bound(entries.begin(), entries.end(), priority, 
+                                 [](uint32_t p, const Eng::Object *o) { return p < getPriority(*o); });
+      entries.insert(it, &obj);
+   }
 };
 
 
@@ -119,6 +166,8 @@ Eng::Container ENG_API &Eng::Container::getInstance()
  */
 Eng::Node ENG_API &Eng::Container::getLastNode() const
 {
+   std::shared_lock<std::shared_mutex> lock(reserved->mutex);
+
    // Safety net:
    if (reserved->allNodes.empty())
       return Eng::Node::empty;
@@ -133,6 +182,8 @@ Eng::Node ENG_API &Eng::Container::getLastNode() const
  */
 Eng::Mesh ENG_API &Eng::Container::getLastMesh() const
 {
+   std::shared_lock<std::shared_mutex> lock(reserved->mutex);
+
    // Safety net:
    if (reserved->allMeshes.empty())
       return Eng::Mesh::empty;
@@ -147,6 +198,8 @@ Eng::Mesh ENG_API &Eng::Container::getLastMesh() const
  */
 Eng::Camera ENG_API &Eng::Container::getLastCamera() const
 {
+   std::shared_lock<std::shared_mutex> lock(reserved->mutex);
+
    // Safety net:
    if (reserved->allCameras.empty())
       return Eng::Camera::empty;
@@ -161,6 +214,8 @@ Eng::Camera ENG_API &Eng::Container::getLastCamera() const
  */
 Eng::Light ENG_API &Eng::Container::getLastLight() const
 {
+   std::shared_lock<std::shared_mutex> lock(reserved->mutex);
+
    // Safety net:
    if (reserved->allLights.empty())
       return Eng::Light::empty;
@@ -175,6 +230,8 @@ Eng::Light ENG_API &Eng::Container::getLastLight() const
  */
 Eng::Bitmap ENG_API &Eng::Container::getLastBitmap() const
 {
+   std::shared_lock<std::shared_mutex> lock(reserved->mutex);
+
    // Safety net:
    if (reserved->allBitmaps.empty())
       return Eng::Bitmap::empty;
@@ -189,6 +246,8 @@ Eng::Bitmap ENG_API &Eng::Container::getLastBitmap() const
  */
 Eng::Material ENG_API &Eng::Container::getLastMaterial() const
 {
+   std::shared_lock<std::shared_mutex> lock(reserved->mutex);
+
    // Safety net:
    if (reserved->allMaterials.empty())
       return Eng::Material::empty;
@@ -203,6 +262,8 @@ Eng::Material ENG_API &Eng::Container::getLastMaterial() const
  */
 Eng::Texture ENG_API &Eng::Container::getLastTexture() const
 {
+   std::shared_lock<std::shared_mutex> lock(reserved->mutex);
+
    // Safety net:
    if (reserved->allTextures.empty())
       return Eng::Texture::empty;
@@ -215,7 +276,7 @@ Eng::Texture ENG_API &Eng::Container::getLastTexture() const
  * Gets direct access to the list of nodes.
  * @return list of nodes
  */
-std::list<Eng::Node> ENG_API &Eng::Container::getNodeList()
+Eng::PooledList<Eng::Node> ENG_API &Eng::Container::getNodeList()
 {  
    return reserved->allNodes;
 }
@@ -226,7 +287,7 @@ std::list<Eng::Node> ENG_API &Eng::Container::getNodeList()
  * Gets direct access to the list of meshes.
  * @return list of meshes
  */
-std::list<Eng::Mesh> ENG_API &Eng::Container::getMeshList()
+Eng::PooledList<Eng::Mesh> ENG_API &Eng::Container::getMeshList()
 {
    return reserved->allMeshes;
 }
@@ -237,7 +298,7 @@ std::list<Eng::Mesh> ENG_API &Eng::Container::getMeshList()
  * Gets direct access to the list of cameras.
  * @return list of cameras
  */
-std::list<Eng::Camera> ENG_API &Eng::Container::getCameraList()
+Eng::PooledList<Eng::Camera> ENG_API &Eng::Container::getCameraList()
 {
    return reserved->allCameras;
 }
@@ -248,7 +309,7 @@ std::list<Eng::Camera> ENG_API &Eng::Container::getCameraList()
  * Gets direct access to the list of lights.
  * @return list of lights
  */
-std::list<Eng::Light> ENG_API &Eng::Container::getLightList()
+Eng::PooledList<Eng::Light> ENG_API &Eng::Container::getLightList()
 {
    return reserved->allLights;
 }
@@ -259,7 +320,7 @@ std::list<Eng::Light> ENG_API &Eng::Container::getLightList()
  * Gets direct access to the list of bitmaps.
  * @return list of bitmaps
  */
-std::list<Eng::Bitmap> ENG_API &Eng::Container::getBitmapList()
+Eng::PooledList<Eng::Bitmap> ENG_API &Eng::Container::getBitmapList()
 {
    return reserved->allBitmaps;
 }
@@ -270,7 +331,7 @@ std::list<Eng::Bitmap> ENG_API &Eng::Container::getBitmapList()
  * Gets direct access to the list of materials.
  * @return list of materials
  */
-std::list<Eng::Material> ENG_API &Eng::Container::getMaterialList()
+Eng::PooledList<Eng::Material> ENG_API &Eng::Container::getMaterialList()
 {
    return reserved->allMaterials;
 }
@@ -281,12 +342,29 @@ std::list<Eng::Material> ENG_API &Eng::Container::getMaterialList()
  * Gets direct access to the list of textures.
  * @return list of textures
  */
-std::list<Eng::Texture> ENG_API &Eng::Container::getTextureList()
+Eng::PooledList<Eng::Texture> ENG_API &Eng::Container::getTextureList()
 {
    return reserved->allTextures;
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns all the objects with the given name, sorted by search priority (materials, textures, meshes, cameras, 
+ * lights, nodes, bitmaps; then by insertion order). Objects are indexed by the name they have when added.
+ * @param name object name
+ * @return objects (possibly none)
+ */
+std::vector<Eng::Object *> ENG_API Eng::Container::findAll(const std::string &name) const
+{
+   std::shared_lock<std::shared_mutex> lock(reserved->mutex);
+   auto it = reserved->byName.find(name);
+   if (it == reserved->byName.end())
+      return {};
+   return it->second;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Returns, if existing, the first object with the given name among its various lists. 
@@ -302,49 +380,17 @@ Eng::Object ENG_API &Eng::Container::find(const std::string &name) const
       return Eng::Object::empty;
    }
 
-   // Seach in materials:
-   for (auto &c : reserved->allMaterials)
-      if (c.getName() == name)
-         return c;
-
-   // Seach in textures:
-   for (auto &c : reserved->allTextures)
-      if (c.getName() == name)
-         return c;
-   
-   // Seach in geometries:
-   for (auto &c : reserved->allMeshes)
-      if (c.getName() == name)
-         return c;
-
-   // Seach in cameras:
-   for (auto &c : reserved->allCameras)
-      if (c.getName() == name)
-         return c;
-
-   // Seach in lights:
-   for (auto &c : reserved->allLights)
-      if (c.getName() == name)
-         return c;
-
-   // Seach in nodes:
-   for (auto &c : reserved->allNodes)
-      if (c.getName() == name)
-         return c;
-
-   // Seach in bitmaps:
-   for (auto &c : reserved->allBitmaps)
-      if (c.getName() == name)
-         return c;
-   
-   // Not found:
-   return Eng::Object::empty;
+   std::shared_lock<std::shared_mutex> lock(reserved->mutex);
+   auto it = reserved->byName.find(name);
+   if (it == reserved->byName.end())
+      return Eng::Object::empty;
+   return *it->second.front();
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Returns, if existing, the first object with the given ID among its various lists.
+ * Returns, if existing, the object with the given ID among its various lists.
  * @param id object id
  * @return found object or empty
  */
@@ -354,43 +400,11 @@ Eng::Object ENG_API &Eng::Container::find(const uint32_t id) const
    if (id == 0)         
       return Eng::Object::empty;   
    
-   // Seach in materials:
-   for (auto &c : reserved->allMaterials)
-      if (c.getId() == id)
-         return c;
-
-   // Seach in textures:
-   for (auto &c : reserved->allTextures)
-      if (c.getId() == id)
-         return c;
-
-   // Seach in geometries:
-   for (auto &c : reserved->allMeshes)
-      if (c.getId() == id)
-         return c;
-
-   // Seach in cameras:
-   for (auto &c : reserved->allCameras)
-      if (c.getId() == id)
-         return c;
-
-   // Seach in lights:
-   for (auto &c : reserved->allLights)
-      if (c.getId() == id)
-         return c;
-
-   // Seach in nodes:
-   for (auto &c : reserved->allNodes)
-      if (c.getId() == id)
-         return c;
-
-   // Seach in bitmaps:
-   for (auto &c : reserved->allBitmaps)
-      if (c.getId() == id)
-         return c;
-
-   // Not found:
-   return Eng::Object::empty;
+   std::shared_lock<std::shared_mutex> lock(reserved->mutex);
+   auto it = reserved->byId.find(id);
+   if (it == reserved->byId.end())
+      return Eng::Object::empty;
+   return *it->second;
 }
 
 
@@ -401,6 +415,7 @@ Eng::Object ENG_API &Eng::Container::find(const uint32_t id) const
  */
 bool ENG_API Eng::Container::reset()
 {
+   std::unique_lock<std::shared_mutex> lock(reserved->mutex);
    reserved->allNodes.clear();
    reserved->allMeshes.clear();   
    reserved->allCameras.clear();
@@ -408,6 +423,11 @@ bool ENG_API Eng::Container::reset()
    reserved->allBitmaps.clear();
    reserved->allMaterials.clear();   
    reserved->allTextures.clear();   
+   reserved->byName.clear();
+   reserved->byId.clear();
+
+   // Release the emptied slabs in bulk:
+   Eng::Pool::trimAll();
    
    // Done:
    setDirty(true);
@@ -428,47 +448,55 @@ bool ENG_API Eng::Container::add(Eng::Object &obj)
       ENG_LOG_ERROR("Invalid params");
       return false;
    }
+   std::unique_lock<std::shared_mutex> lock(reserved->mutex);
 
    // Sort by type:
    if (dynamic_cast<Eng::Mesh *>(&obj))
    {
       reserved->allMeshes.push_back(std::move(dynamic_cast<Eng::Mesh &>(obj)));      
+      reserved->index(reserved->allMeshes.back());
       return true;
    }
    else
       if (dynamic_cast<Eng::Camera *>(&obj))
       {
          reserved->allCameras.push_back(std::move(dynamic_cast<Eng::Camera &>(obj)));
+         reserved->index(reserved->allCameras.back());
          return true;
       }
       else
          if (dynamic_cast<Eng::Light *>(&obj))
          {
             reserved->allLights.push_back(std::move(dynamic_cast<Eng::Light &>(obj)));      
+            reserved->index(reserved->allLights.back());
             return true;
          }
          else      
             if (dynamic_cast<Eng::Node *>(&obj))
             {
                reserved->allNodes.push_back(std::move(dynamic_cast<Eng::Node &>(obj)));         
+               reserved->index(reserved->allNodes.back());
                return true;
             }      
             else
                if (dynamic_cast<Eng::Material *>(&obj))
                {
                   reserved->allMaterials.push_back(std::move(dynamic_cast<Eng::Material &>(obj)));         
+                  reserved->index(reserved->allMaterials.back());
                   return true;
                }      
                else
                   if (dynamic_cast<Eng::Texture *>(&obj))
                   {
                      reserved->allTextures.push_back(std::move(dynamic_cast<Eng::Texture &>(obj)));         
+                     reserved->index(reserved->allTextures.back());
                      return true;
                   }      
                   else
                      if (dynamic_cast<Eng::Bitmap *>(&obj))
                      {
                         reserved->allBitmaps.push_back(std::move(dynamic_cast<Eng::Bitmap &>(obj)));
+                        reserved->index(reserved->allBitmaps.back());
                         return true;
                      }
    
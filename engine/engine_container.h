@@ -9,7 +9,8 @@
 
 
 /**
- * @brief Class for storing data used during the life-cycle of the engine. 
+ * @brief Class for storing data used during the life-cycle of the engine. Objects can be added and looked up by 
+ *        concurrent threads, while direct access to the lists is meant for a single thread.
  */
 class ENG_API Container final : public Eng::Object
 {
@@ -31,6 +32,22 @@ public: //
    bool add(Eng::Object &obj);
    bool reset();
 
+
+   /**
+    * Adds the given object and returns the stored instance. Unlike add() followed by getLast*(), this is safe while
+    * other threads are adding objects too.
+    * @param obj object to move into the container
+    * @return stored object or T::empty on failure
+    */
+   template <typename T> T &store(T &obj)
+   {
+      const uint32_t id = obj.getId();
+      if (!add(obj))
+         return T::empty;
+      return find<T>(id);
+   }
+
+
    // Get/set:
    Eng::Node &getLastNode() const;
    Eng::Mesh &getLastMesh() const;   
@@ -39,19 +56,45 @@ public: //
    Eng::Bitmap &getLastBitmap() const;
    Eng::Material &getLastMaterial() const;   
    Eng::Texture &getLastTexture() const;   
-   std::list<Eng::Node> &getNodeList();
-   std::list<Eng::Mesh> &getMeshList();
-   std::list<Eng::Camera> &getCameraList();
-   std::list<Eng::Light> &getLightList();
-   std::list<Eng::Bitmap> &getBitmapList();
-   std::list<Eng::Material> &getMaterialList();
-   std::list<Eng::Texture> &getTextureList();
+   Eng::PooledList<Eng::Node> &getNodeList();
+   Eng::PooledList<Eng::Mesh> &getMeshList();
+   Eng::PooledList<Eng::Camera> &getCameraList();
+   Eng::PooledList<Eng::Light> &getLightList();
+   Eng::PooledList<Eng::Bitmap> &getBitmapList();
+   Eng::PooledList<Eng::Material> &getMaterialList();
+   Eng::PooledList<Eng::Texture> &getTextureList();
    
    // Finders:
    Eng::Object &find(const std::string &name) const;   ///< By name
    Eng::Object &find(uint32_t id) const;               ///< By ID
 
 
+   /**
+    * Returns, if existing, the first object of the given type with the given name.
+    * @param name object name
+    * @return found object or T::empty
+    */
+   template <typename T> T &find(const std::string &name) const
+   {
+      for (Eng::Object *obj : findAll(name))
+         if (T *typed = dynamic_cast<T *>(obj))
+            return *typed;
+      return T::empty;
+   }
+
+
+   /**
+    * Returns, if existing, the object of the given type with the given ID.
+    * @param id object id
+    * @return found object or T::empty
+    */
+   template <typename T> T &find(uint32_t id) const
+   {
+      T *typed = dynamic_cast<T *>(&find(id));
+      return typed ? *typed : T::empty;
+   }
+
+
 ///////////
 private: //
 ///////////
@@ -65,6 +108,9 @@ private: //
    Container();
    Container(Container &&other);
 
+   // Finders:
+   std::vector<Eng::Object *> findAll(const std::string &name) const;
+
    // Workaround for disabling the unneeded rendering method:
    using Object::render;
 };
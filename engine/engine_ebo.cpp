@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM resource
+
    // Main include:
    #include "engine.h"
 
@@ -40,12 +43,13 @@ struct Eng::Ebo::Reserved
 {  
    GLuint oglId;        ///< OpenGL shader ID
    uint32_t nrOfFaces;  ///< Nr. of faces
+   IndexType type;      ///< Type of the indices
 
 
    /**
     * Constructor.
     */
-   Reserved() : oglId{ 0 }, nrOfFaces{ 0 }
+   Reserved() : oglId{ 0 }, nrOfFaces{ 0 }, type{ IndexType::uint32 }
    {}
 };
 
@@ -120,6 +124,39 @@ uint32_t ENG_API Eng::Ebo::getNrOfFaces() const
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Return the type of the indices stored in this EBO.
+ * @return index type
+ */
+Eng::Ebo::IndexType ENG_API Eng::Ebo::getIndexType() const
+{
+   return reserved->type;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Return the size of a face in this EBO.
+ * @return size in bytes
+ */
+uint32_t ENG_API Eng::Ebo::getFaceSize() const
+{
+   return reserved->type == IndexType::uint16 ? sizeof(FaceData16) : sizeof(FaceData);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Return the OpenGL enum of the index type, as required by the glDrawElements* family.
+ * @return GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+ */
+uint32_t ENG_API Eng::Ebo::getOglIndexType() const
+{
+   return reserved->type == IndexType::uint16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Initializes an OpenGL EBO.
@@ -133,7 +170,7 @@ bool ENG_API Eng::Ebo::init()
    // Free buffer if already stored:
    if (reserved->oglId)   
    {   
-	   glDeleteBuffers(1, &reserved->oglId);    
+	   Eng::Managed::release(Eng::Managed::Resource::buffer, reserved->oglId);    
       reserved->oglId = 0;   
       reserved->nrOfFaces = 0;
    }   
@@ -159,7 +196,7 @@ bool ENG_API Eng::Ebo::free()
    // Free EBO if stored:
    if (reserved->oglId)
    {
-      glDeleteBuffers(1, &reserved->oglId);
+      Eng::Managed::release(Eng::Managed::Resource::buffer, reserved->oglId);
       reserved->oglId = 0;
       reserved->nrOfFaces = 0;
    }
@@ -171,22 +208,30 @@ bool ENG_API Eng::Ebo::free()
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Create element buffer by allocating the required storage.
+ * Create element buffer by allocating the required storage (padded to a multiple of 4 bytes).
  * @param nfOfFaces number of faces to store
  * @param data pointer to the data to copy into the buffer
+ * @param type type of the indices (FaceData for uint32, FaceData16 for uint16)
  * @return TF
  */
-bool ENG_API Eng::Ebo::create(uint32_t nrOfFaces, const void *data)
+bool ENG_API Eng::Ebo::create(uint32_t nrOfFaces, const void *data, IndexType type)
 {	
    // Init buffer:
    if (!this->isInitialized())
       this->init();
-   uint64_t size = nrOfFaces * sizeof(FaceData); 
+   reserved->type = type;
+   uint64_t size = static_cast<uint64_t>(nrOfFaces) * getFaceSize(); 
+
+   // Storage is padded to a multiple of 4 bytes, so that 16-bit indices can be read as 32-bit words by shaders:
+   const uint64_t paddedSize = (size + 3) & ~static_cast<uint64_t>(3);
 
 	// Create it:		              
    const GLuint oglId = this->getOglHandle();
    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, oglId);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, GL_STATIC_DRAW); 
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, paddedSize, (paddedSize == size) ? data : nullptr, GL_STATIC_DRAW); 
+   if (paddedSize != size && data)
+      glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, size, data);
+   this->setMemoryUsage(MemoryType::indexBuffer, paddedSize);
 
    // Done:
    reserved->nrOfFaces = nrOfFaces;
@@ -194,6 +239,30 @@ bool ENG_API Eng::Ebo::create(uint32_t nrOfFaces, const void *data)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Create element buffer from 32-bit faces, storing them as 16-bit indices when the vertex count allows it.
+ * @param nfOfFaces number of faces to store
+ * @param data faces
+ * @param nrOfVertices number of vertices addressed by the faces
+ * @return TF
+ */
+bool ENG_API Eng::Ebo::create(uint32_t nrOfFaces, const FaceData *data, uint32_t nrOfVertices)
+{
+   if (nrOfVertices > 65536 || data == nullptr)
+      return create(nrOfFaces, data, IndexType::uint32);
+
+   std::vector<FaceData16> faces16(nrOfFaces);
+   for (uint32_t c = 0; c < nrOfFaces; c++)
+   {
+      faces16[c].a = static_cast<uint16_t>(data[c].a);
+      faces16[c].b = static_cast<uint16_t>(data[c].b);
+      faces16[c].c = static_cast<uint16_t>(data[c].c);
+   }
+   return create(nrOfFaces, faces16.data(), IndexType::uint16);
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Rendering method. 
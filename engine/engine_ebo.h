@@ -21,6 +21,16 @@ public: //
    static Ebo empty;
 
 
+   /**
+    * @brief Type of the indices stored in the buffer.
+    */
+   enum class IndexType : uint32_t
+   {
+      uint16,
+      uint32
+   };
+
+
    /** 
     * @brief Per-face data
     */	
@@ -37,6 +47,22 @@ public: //
 	};      
 
 
+   /** 
+    * @brief Per-face data, compact version (for meshes with up to 65536 vertices)
+    */	
+   struct FaceData16
+   {		
+		uint16_t a, b, c;
+
+
+      /**
+       * Constructor. 
+       */
+      inline FaceData16() noexcept : a{ 0 }, b{ 0 }, c{ 0 }
+      {}
+	};      
+
+
    // Const/dest:
    Ebo();
    Ebo(Ebo &&other);
@@ -45,10 +71,14 @@ public: //
    
    // Get/set:   
    uint32_t getNrOfFaces() const;
+   IndexType getIndexType() const;
+   uint32_t getFaceSize() const;
+   uint32_t getOglIndexType() const;
    uint32_t getOglHandle() const;
 
    // Data:
-   bool create(uint32_t nrOfFaces, const void *data = nullptr);
+   bool create(uint32_t nrOfFaces, const void *data = nullptr, IndexType type = IndexType::uint32);
+   bool create(uint32_t nrOfFaces, const FaceData *data, uint32_t nrOfVertices);
 
    // Rendering methods:   
    bool render(uint32_t value = 0, void *data = nullptr) const;
@@ -10,6 +10,9 @@
 // #INCLUDE //
 //////////////
 
+// Logging subsystem:
+#define ENG_LOG_SUBSYSTEM resource
+
 // Main include:
 #include "engine.h"
 
@@ -123,7 +126,7 @@ bool ENG_API Eng::Fbo::init()
     // Free texture if already stored:
     if (reserved->oglId)
     {
-        glDeleteFramebuffers(1, &reserved->oglId);
+        Eng::Managed::release(Eng::Managed::Resource::framebuffer, reserved->oglId);
         reserved->oglId = 0;
     }
 
@@ -154,7 +157,7 @@ bool ENG_API Eng::Fbo::free()
         /////////////////////////////////////////////////         
         case Eng::Fbo::Attachment::Type::depth_buffer: //         
             GLuint oglId = static_cast<GLuint>(att.data);
-            glDeleteRenderbuffers(1, &oglId);
+            Eng::Managed::release(Eng::Managed::Resource::renderbuffer, oglId);
             break;
         }
 
@@ -164,7 +167,7 @@ bool ENG_API Eng::Fbo::free()
     // Free framebuffer if used:
     if (reserved->oglId)
     {
-        glDeleteFramebuffers(1, &reserved->oglId);
+        Eng::Managed::release(Eng::Managed::Resource::framebuffer, reserved->oglId);
         reserved->oglId = 0;
     }
 
@@ -301,6 +304,7 @@ bool ENG_API Eng::Fbo::attachDepthBuffer(uint32_t sizeX, uint32_t sizeY)
     // Done:   
     att.data = oglId;
     reserved->attachment.push_back(att);
+    this->setMemoryUsage(MemoryType::renderbuffer, this->getMemoryUsage() + static_cast<uint64_t>(sizeX) * sizeY * sizeof(float));
     return updateMrtCache();
 }
 
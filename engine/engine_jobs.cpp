@@ -0,0 +1,306 @@
+/**
+ * @file		engine_jobs.cpp
+ * @brief	Work-stealing job system
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+
+
+
+//////////////
+// #INCLUDE //
+//////////////
+
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM core
+
+   // Main include:
+   #include "engine.h"
+
+   // C/C++:
+   #include <deque>
+   #include <thread>
+   #include <mutex>
+   #include <condition_variable>
+   #include <algorithm>
+
+
+
+////////////
+// STATIC //
+////////////
+
+   // Index of the deque owned by the current thread (0 is shared by all the threads outside the pool):
+   static thread_local uint32_t currentWorker = 0;
+
+
+
+/////////////////////////
+// RESERVED STRUCTURES //
+/////////////////////////
+
+/**
+ * @brief Jobs reserved structure.
+ */
+struct Eng::Jobs::Reserved
+{
+   /**
+    * @brief Job queued along with the group to notify on completion.
+    */
+   struct Task
+   {
+      Eng::Jobs::Job job;
+      Eng::Jobs::Group *group;
+   };
+
+   /**
+    * @brief Deque owned by a worker.
+    */
+   struct Queue
+   {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+   };
+
+   std::vector<std::unique_ptr<Queue>> queues;     ///< One per worker, 0 included
+   std::vector<std::thread> threads;               ///< Workers 1 to n (worker 0 is the thread waiting for a group)
+   std::atomic<uint32_t> nrOfQueued;               ///< Jobs waiting in any queue
+   std::atomic<bool> quit;                         ///< Set when the workers must terminate
+   std::mutex sleepMutex;                          ///< Used by idle workers only
+   std::condition_variable wakeUp;                 ///< Signaled when new jobs are queued
+
+
+   /**
+    * Constructor.
+    */
+   Reserved() : nrOfQueued{ 0 }, quit{ false }
+   {}
+
+
+   /**
+    * Gets the next job, from the back of the worker's own deque first, then from the front of the others.
+    * @param worker worker id
+    * @param task filled with the job found
+    * @return TF
+    */
+   bool next(uint32_t worker, Task &task)
+   {
+      const uint32_t nrOfQueues = static_cast<uint32_t>(queues.size());
+      for (uint32_t c = 0; c < nrOfQueues; c++)
+      {
+         Queue &queue = *queues[(worker + c) % nrOfQueues];
+         std::lock_guard<std::mutex> lock(queue.mutex);
+         if (queue.tasks.empty())
+            continue;
+         if (c == 0)
+         {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+         }
+         else
+         {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+         }
+         nrOfQueued--;
+         return true;
+      }
+      return false;
+   }
+};
+
+
+
+////////////////////////
+// BODY OF CLASS Jobs //
+////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Constructor. Spawns one worker per core, minus the calling thread.
+ */
+ENG_API Eng::Jobs::Jobs() : reserved(std::make_unique<Eng::Jobs::Reserved>())
+{
+   ENG_LOG_DETAIL("[+]");
+
+   const uint32_t nrOfWorkers = std::max(1u, std::thread::hardware_concurrency());
+   for (uint32_t c = 0; c < nrOfWorkers; c++)
+      reserved->queues.push_back(std::make_unique<Reserved::Queue>());
+
+   for (uint32_t c = 1; c < nrOfWorkers; c++)
+      reserved->threads.emplace_back([this, c]()
+      {
+         currentWorker = c;
+         while (!reserved->quit)
+         {
+            if (execute(c))
+               continue;
+
+            std::unique_lock<std::mutex> lock(reserved->sleepMutex);
+            reserved->wakeUp.wait(lock, [this]() { return reserved->quit || reserved->nrOfQueued > 0; });
+         }
+      });
+
+   ENG_LOG_DEBUG("Job system started with %u workers", nrOfWorkers);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Destructor.
+ */
+ENG_API Eng::Jobs::~Jobs()
+{
+   free();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Stops and joins the workers (e.g., before unloading the engine). Jobs submitted afterwards are still accepted, 
+ * but executed by the threads waiting for them.
+ * @return TF
+ */
+bool ENG_API Eng::Jobs::free()
+{
+   {
+      std::lock_guard<std::mutex> lock(reserved->sleepMutex);
+      reserved->quit = true;
+   }
+   reserved->wakeUp.notify_all();
+   for (auto &thread : reserved->threads)
+      thread.join();
+   reserved->threads.clear();
+
+   // Done:
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the singleton instance. Workers are started at the first call.
+ * @return singleton instance
+ */
+Eng::Jobs ENG_API &Eng::Jobs::getInstance()
+{
+   static Jobs instance;
+   return instance;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of workers, including the thread waiting for the jobs.
+ * @return number of workers
+ */
+uint32_t ENG_API Eng::Jobs::getNrOfWorkers() const
+{
+   return static_cast<uint32_t>(reserved->queues.size());
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the id of the calling worker, for indexing per-worker data.
+ * @return worker id (0 for threads outside the pool)
+ */
+uint32_t ENG_API Eng::Jobs::getWorkerId() const
+{
+   return currentWorker;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Submits a job to the deque of the calling worker.
+ * @param group group the job belongs to (must outlive it)
+ * @param job job to execute
+ */
+void ENG_API Eng::Jobs::run(Eng::Jobs::Group &group, Eng::Jobs::Job job)
+{
+   // Safety net:
+   if (!job)
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return;
+   }
+
+   group.pending++;
+   {
+      Reserved::Queue &queue = *reserved->queues[currentWorker];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.push_back({ std::move(job), &group });
+   }
+   reserved->nrOfQueued++;
+
+   // Wake up an idle worker (the lock avoids missing a worker about to sleep):
+   {
+      std::lock_guard<std::mutex> lock(reserved->sleepMutex);
+   }
+   reserved->wakeUp.notify_one();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Waits for all the jobs of a group to complete, executing pending jobs (of any group) meanwhile.
+ * @param group group to join
+ */
+void ENG_API Eng::Jobs::wait(Eng::Jobs::Group &group)
+{
+   while (group.pending > 0)
+      if (!execute(currentWorker))
+         std::this_thread::yield();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Splits the range [0, count) into chunks processed in parallel and waits for their completion.
+ * @param count number of items
+ * @param grainSize items per chunk (0 for an automatic size, giving a few chunks per worker)
+ * @param job function called with the [begin, end) range of each chunk
+ */
+void ENG_API Eng::Jobs::parallelFor(uint32_t count, uint32_t grainSize, const Eng::Jobs::RangeJob &job)
+{
+   if (count == 0)
+      return;
+   if (grainSize == 0)
+      grainSize = std::max(1u, count / (getNrOfWorkers() * 4));
+
+   // Not worth splitting:
+   if (count <= grainSize)
+   {
+      job(0, count);
+      return;
+   }
+
+   Group group;
+   for (uint32_t begin = 0; begin < count; begin += grainSize)
+   {
+      const uint32_t end = std::min(count, begin + grainSize);
+      run(group, [&job, begin, end]() { job(begin, end); });
+   }
+   wait(group);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Executes one pending job, if any.
+ * @param workerId id of the calling worker
+ * @return TF
+ */
+bool ENG_API Eng::Jobs::execute(uint32_t workerId)
+{
+   Reserved::Task task;
+   if (!reserved->next(workerId, task))
+      return false;
+
+   task.job();
+   task.group->pending--;
+
+   // Done:
+   return true;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file		engine_jobs.h
+ * @brief	Work-stealing job system
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+#pragma once
+
+
+
+/**
+ * @brief Work-stealing job system, sized to the number of cores. Each worker owns a deque: it pushes and pops its
+ *        jobs at the back while idle workers steal from the front of the others. Threads waiting for a group keep
+ *        executing pending jobs, so fork/join can be nested. This class is a singleton.
+ */
+class ENG_API Jobs final
+{
+//////////
+public: //
+//////////
+
+   // Job signatures:
+   typedef std::function<void()> Job;
+   typedef std::function<void(uint32_t begin, uint32_t end)> RangeJob;
+
+
+   /**
+    * @brief Set of jobs joined together through wait().
+    */
+   class ENG_API Group
+   {
+   public:
+      Group() : pending{ 0 } {}
+      Group(Group const &) = delete;
+      bool isDone() const { return pending == 0; }
+
+   private:
+      friend class Jobs;
+      std::atomic<uint32_t> pending;      ///< Jobs submitted and not completed yet
+   };
+
+
+   // Const/dest:
+   Jobs(Jobs const &) = delete;
+   ~Jobs();
+
+   // Operators:
+   void operator=(Jobs const &) = delete;
+
+   // Singleton:
+   static Jobs &getInstance();
+   bool free();
+
+   // Get/set:
+   uint32_t getNrOfWorkers() const;
+   uint32_t getWorkerId() const;
+
+   // Fork/join:
+   void run(Group &group, Job job);
+   void wait(Group &group);
+   void parallelFor(uint32_t count, uint32_t grainSize, const RangeJob &job);
+
+
+///////////
+private: //
+///////////
+
+   // Reserved:
+   struct Reserved;
+   std::unique_ptr<Reserved> reserved;
+
+   // Const/dest:
+   Jobs();
+
+   // Scheduling:
+   bool execute(uint32_t workerId);
+};
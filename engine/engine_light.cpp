@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM scene
+
    // Main include:
    #include "engine.h"
 
@@ -25,6 +28,28 @@
 
 
 
+/**
+ * @brief Light chunk data, following the node properties.
+ */
+struct LightChunk
+{
+   uint8_t subtype;
+   glm::vec3 color;
+   float radius;
+   glm::vec3 direction;
+   float cutoff;
+   float spotExponent;
+   uint8_t castShadows;
+   uint8_t isVolumetric;
+};
+
+   // Packed layout:
+   static constexpr auto lightChunkSchema = Eng::Serializer::schema(&LightChunk::subtype, &LightChunk::color, 
+      &LightChunk::radius, &LightChunk::direction, &LightChunk::cutoff, &LightChunk::spotExponent, 
+      &LightChunk::castShadows, &LightChunk::isVolumetric);
+
+
+
 /////////////////////////
 // RESERVED STRUCTURES //
 /////////////////////////
@@ -37,13 +62,18 @@ struct Eng::Light::Reserved
    glm::vec3 color;              ///< Light color
    glm::vec3 ambient;            ///< Ambient color
    glm::mat4 projMatrix;         ///< Projection matrix used for shadow mapping
+   LightChunk props;             ///< Properties read from the OVO file (kept for saving)
+
+
+   // Allocated from a pool:
+   ENG_POOLED(Reserved)
 
 
    /**
     * Constructor. 
     */
    Reserved() : color{ 1.0f }, ambient { 0.25f },
-                projMatrix{ 1.0f }
+                projMatrix{ 1.0f }, props{}
    {}
 };
 
@@ -170,51 +200,47 @@ const glm::mat4 ENG_API &Eng::Light::getProjMatrix() const
 uint32_t ENG_API Eng::Light::loadChunk(Eng::Serializer &serial, void *data)
 {
    // Chunk header
-   uint32_t chunkId;
-   serial.deserialize(&chunkId, sizeof(uint32_t));
-   if (chunkId != static_cast<uint32_t>(Ovo::ChunkId::light))
+   Ovo::ChunkHeader header;
+   if (!serial.read(header, Ovo::chunkHeaderSchema) || header.id != static_cast<uint32_t>(Ovo::ChunkId::light))
    {
       ENG_LOG_ERROR("Invalid chunk ID found");
       return 0;
    }
-   uint32_t chunkSize;
-   serial.deserialize(&chunkSize, sizeof(uint32_t));
 
    // Node properties:       
-   std::string name;
-   serial.deserialize(name);   
-   this->setName(name);
+   ChunkProps props;
+   if (!loadChunkProps(serial, props))
+      return 0;
+   this->setMatrix(props.matrix);
+   
+   // Data:
+   if (!serial.read(reserved->props, lightChunkSchema))
+      return 0;
+   reserved->color = reserved->props.color;
 
-   glm::mat4 matrix;
-   serial.deserialize(matrix);
-   this->setMatrix(matrix);
+   // Done:      
+   return props.nrOfChildren;
+}
 
-   uint32_t nrOfChildren;
-   serial.deserialize(nrOfChildren);
 
-   std::string target;
-   serial.deserialize(target);   
-   
-   // Data:
-   uint8_t subtype;
-   serial.deserialize(subtype);
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves the specific information of a given object.
+ * @param serial serial data to append the chunk to
+ * @param data optional pointer
+ * @return TF
+ */
+bool ENG_API Eng::Light::saveChunk(Eng::Serializer &serial, void *data) const
+{
+   LightChunk props = reserved->props;
+   props.color = reserved->color;
 
-   serial.deserialize(reserved->color);
-   float radius;
-   serial.deserialize(radius);
-   glm::vec3 direction;
-   serial.deserialize(direction);
-   float cutoff;
-   serial.deserialize(cutoff);
-   float spotExponent;
-   serial.deserialize(spotExponent);
-   uint8_t castShadows;
-   serial.deserialize(castShadows);
-   uint8_t isVolumetric;
-   serial.deserialize(isVolumetric);  
+   Eng::Serializer body;
+   if (!saveChunkProps(body, getChunkProps()) || !body.write(props, lightChunkSchema))
+      return false;
 
-   // Done:      
-   return nrOfChildren;
+   // Done:
+   return appendChunk(serial, Ovo::ChunkId::light, body);
 }
 
 
@@ -42,6 +42,7 @@ public: //
    
    // Ovo:   
    uint32_t loadChunk(Eng::Serializer &serial, void *data = nullptr) override;
+   bool saveChunk(Eng::Serializer &serial, void *data = nullptr) const override;
 
 
 ///////////
@@ -10,8 +10,18 @@
 // #INCLUDE //
 //////////////
 
+// Logging subsystem:
+#define ENG_LOG_SUBSYSTEM scene
+
 // Main include:
 #include "engine.h"
+#include "engine_ssbo.h"
+
+// C/C++:
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <mutex>
 
 
 ////////////
@@ -22,6 +32,82 @@
 Eng::List Eng::List::empty("[empty]");
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * LSD radix sort of 64-bit keys (8 bits per pass), carrying along an array of values. Passes where all the keys
+ * share the same digit are skipped.
+ * @param keys keys to sort (sorted on return)
+ * @param values values to reorder accordingly
+ * @param tmpKeys scratch buffer
+ * @param tmpValues scratch buffer
+ */
+static void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values,
+                      std::vector<uint64_t>& tmpKeys, std::vector<uint32_t>& tmpValues)
+{
+    const size_t size = keys.size();
+    if (size < 2)
+        return;
+    tmpKeys.resize(size);
+    tmpValues.resize(size);
+
+    for (uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        size_t offset[257] = {0};
+        for (size_t c = 0; c < size; c++)
+            offset[((keys[c] >> shift) & 0xff) + 1]++;
+        if (offset[((keys[0] >> shift) & 0xff) + 1] == size)
+            continue;
+        for (uint32_t c = 1; c < 257; c++)
+            offset[c] += offset[c - 1];
+        for (size_t c = 0; c < size; c++)
+        {
+            const size_t dst = offset[(keys[c] >> shift) & 0xff]++;
+            tmpKeys[dst] = keys[c];
+            tmpValues[dst] = values[c];
+        }
+        keys.swap(tmpKeys);
+        values.swap(tmpValues);
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Converts a view-space distance into an order-preserving unsigned integer (positive floats compare as integers).
+ * @param distance distance from the viewer (negative values are clamped to 0)
+ * @return sortable integer
+ */
+static uint32_t depthToKey(float distance)
+{
+    if (!(distance > 0.0f))
+        return 0;
+    uint32_t bits;
+    memcpy(&bits, &distance, sizeof(uint32_t));
+    return bits;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the level of detail matching a projected size, given the LOD thresholds scaled by a factor.
+ * @param size projected bounding sphere radius, relative to half the screen height
+ * @param nrOfLods number of available LODs
+ * @param scale factor applied to the thresholds
+ * @return level of detail
+ */
+static uint32_t lodForSize(float size, uint32_t nrOfLods, float scale)
+{
+    uint32_t lod = 0;
+    float threshold = Eng::List::lodThreshold * scale;
+    while (lod + 1 < nrOfLods && size < threshold)
+    {
+        lod++;
+        threshold *= 0.5f;
+    }
+    return lod;
+}
+
+
 /////////////////////////
 // RESERVED STRUCTURES //
 /////////////////////////
@@ -31,16 +117,502 @@ Eng::List Eng::List::empty("[empty]");
  */
 struct Eng::List::Reserved
 {
-    std::vector<Eng::List::RenderableElem> renderableElem; ///< List of rendering elements
-    uint32_t nrOfLights; ///< Number of lights in the list (lights come first)
-    uint32_t nrOfSolidMeshes; ///< Number of solid meshes in the list (after lights)
+    /**
+     * @brief Position of a tracked node within the list.
+     */
+    struct Slot
+    {
+        Eng::List::Pass category; ///< Array holding the element (none for non-renderable nodes)
+        uint32_t index; ///< Position in that array
+        uint32_t baseId; ///< Index of the base matrix applied to the world matrix
+        const Eng::Node* parent; ///< Parent node at the time of the insertion
+        std::vector<const Eng::Node*> children; ///< Tracked children (used as keys only, never dereferenced)
+    };
+
+    /**
+     * @brief Node collected during a traversal, before being merged into the arrays.
+     */
+    struct Entry
+    {
+        const Eng::Node* node; ///< Collected node
+        const Eng::Node* parent; ///< Parent node
+        Eng::List::Pass category; ///< Array that will hold the element (none for non-renderable nodes)
+        glm::mat4 matrix; ///< Final matrix (renderable elements only)
+    };
+
+    std::vector<Eng::List::RenderableElem> lights; ///< Lights
+    std::vector<Eng::List::RenderableElem> solidMeshes; ///< Opaque meshes
+    std::vector<Eng::List::RenderableElem> transparents; ///< Meshes with opacity < 1
+    std::unordered_map<const Eng::Node*, Slot> slots; ///< All the nodes tracked by the list
+    std::vector<glm::mat4> baseMatrices; ///< Matrices passed to process() (0 is identity)
+    uint64_t worldVersion; ///< Node world version matrices are up to date with
+    uint64_t passVersion; ///< Material pass version meshes are sorted into solid and transparent with
+
+    // Render queue:
+    /**
+     * @brief Draw order computed for a given camera.
+     */
+    struct Order
+    {
+        glm::mat4 camera; ///< Camera matrix used for the sort
+        std::vector<uint32_t> elems; ///< Positions of the elements in draw order
+        bool valid; ///< False once the elements changed since the sort
+    };
+
+    constexpr static uint32_t maxNrOfOrders = 4; ///< Orders kept per array (e.g., shadow and main passes)
+    std::vector<Order> solidOrders; ///< Solid meshes sorted by state key, most recently used first
+    bool solidOrderDirty; ///< True when all the solid orders must be rebuilt
+    std::vector<Order> transparentOrders; ///< Transparent meshes sorted back-to-front, most recently used first
+    bool transparentOrderDirty; ///< True when all the transparent orders must be rebuilt
+    std::vector<float> distances; ///< View-space distances scratch buffer
+    std::vector<uint64_t> sortKeys, tmpKeys; ///< Sort scratch buffers
+    std::vector<uint32_t> tmpValues; ///< Sort scratch buffer
+
+    // Instancing:
+    /**
+     * @brief Run of consecutive visible solid meshes sharing geometry and material.
+     */
+    struct Batch
+    {
+        uint32_t first; ///< Position of the first element in visibleOrder
+        uint32_t count; ///< Number of elements
+        uint32_t baseInstance; ///< Position of the first matrix in the instance buffer (count > 1 only)
+    };
+
+    Eng::Ssbo instanceBuffer; ///< Per-instance modelview matrices (bound at binding 5)
+    std::vector<glm::mat4> instanceMatrices; ///< CPU-side copy of the instance buffer
+    std::vector<uint32_t> visibleOrder; ///< Visible solid meshes in sorted order
+    std::vector<Batch> batches; ///< Solid draws of the current pass
+
+    // Scene graph events:
+    /**
+     * @brief Node attached or detached, possibly by another thread.
+     */
+    struct Event
+    {
+        const Eng::Node* parent; ///< Parent node (never dereferenced)
+        const Eng::Node* child; ///< Child node (nullptr when canceled)
+        bool added; ///< True when attached, false when detached or released
+    };
+
+    std::mutex eventMutex; ///< Guards the event queue (the only state touched by the listener callbacks)
+    std::vector<Event> events; ///< Events not applied yet, in order
+    std::unordered_map<const Eng::Node*, size_t> pendingAdds; ///< Position in events of the queued insertions
+    std::vector<Event> applied; ///< Events being applied (kept to reuse its storage)
 
 
     /**
      * Constructor. 
      */
-    Reserved() : nrOfLights{0}, nrOfSolidMeshes{0}
+    Reserved() : baseMatrices{glm::mat4(1.0f)}, worldVersion{0}, passVersion{Eng::Material::getPassVersion()},
+                 solidOrderDirty{true}, transparentOrderDirty{true}
+    {
+    }
+
+
+    /**
+     * Gets the array storing the given category.
+     * @param category lights, meshes or transparents
+     * @return array of elements
+     */
+    std::vector<Eng::List::RenderableElem>& getArray(Eng::List::Pass category)
+    {
+        if (category == Eng::List::Pass::lights)
+            return lights;
+        if (category == Eng::List::Pass::meshes)
+            return solidMeshes;
+        return transparents;
+    }
+
+
+    /**
+     * Computes the final matrix of a node.
+     * @param node node
+     * @param baseId index of the base matrix
+     * @return final matrix
+     */
+    glm::mat4 getMatrix(const Eng::Node& node, uint32_t baseId) const
+    {
+        if (baseId == 0)
+            return node.getWorldMatrix();
+        return baseMatrices[baseId] * node.getWorldMatrix();
+    }
+
+
+    /**
+     * Gets the array a node belongs to.
+     * @param node node
+     * @return lights, meshes, transparents or none for non-renderable nodes
+     */
+    static Eng::List::Pass getCategory(const Eng::Node& node)
+    {
+        if (dynamic_cast<const Eng::Light*>(&node))
+            return Eng::List::Pass::lights;
+        if (const auto mesh = dynamic_cast<const Eng::Mesh*>(&node))
+            return (mesh->getMaterial().getOpacity() < 1.0f) ? Eng::List::Pass::transparents : Eng::List::Pass::meshes;
+        return Eng::List::Pass::none;
+    }
+
+
+    /**
+     * Collects a single node (its children excluded).
+     * @param node node
+     * @param parent parent node
+     * @param baseId index of the base matrix
+     * @param entries buffer to append to
+     */
+    void visit(const Eng::Node& node, const Eng::Node* parent, uint32_t baseId, std::vector<Entry>& entries) const
+    {
+        Entry entry;
+        entry.node = &node;
+        entry.parent = parent;
+        entry.category = getCategory(node);
+        if (entry.category != Eng::List::Pass::none)
+            entry.matrix = getMatrix(node, baseId);
+        entries.push_back(entry);
+    }
+
+
+    /**
+     * Recursively collects the nodes of a subtree not tracked yet. The list is not modified, so distinct subtrees 
+     * can be collected in parallel.
+     * @param node subtree root
+     * @param parent parent of the subtree root
+     * @param baseId index of the base matrix
+     * @param entries buffer to append to
+     */
+    void collect(const Eng::Node& node, const Eng::Node* parent, uint32_t baseId, std::vector<Entry>& entries) const
+    {
+        if (slots.count(&node))
+            return;
+        visit(node, parent, baseId, entries);
+        for (auto& n : node.getListOfChildren())
+            collect(n, &node, baseId, entries);
+    }
+
+
+    /**
+     * Appends collected nodes to the arrays and starts tracking them. Each node is also linked to the slot of its
+     * parent (when tracked), so that subtrees can later be dropped without walking the scene graph.
+     * @param entries collected nodes (parents before their children)
+     * @param baseId index of the base matrix
+     */
+    void merge(const std::vector<Entry>& entries, uint32_t baseId)
+    {
+        if (entries.empty())
+            return;
+
+        slots.reserve(slots.size() + entries.size());
+        for (const Entry& entry : entries)
+        {
+            Slot slot;
+            slot.category = entry.category;
+            slot.index = 0;
+            slot.baseId = baseId;
+            slot.parent = entry.parent;
+            if (slot.category != Eng::List::Pass::none)
+            {
+                RenderableElem re;
+                re.matrix = entry.matrix;
+                re.reference = *entry.node;
+                auto& array = getArray(slot.category);
+                slot.index = static_cast<uint32_t>(array.size());
+                array.push_back(re);
+                solidOrderDirty = true;
+                transparentOrderDirty = true;
+            }
+            slots[entry.node] = std::move(slot);
+
+            auto parent = slots.find(entry.parent);
+            if (parent != slots.end())
+                parent->second.children.push_back(entry.node);
+        }
+    }
+
+
+    /**
+     * Gets the cached order matching a camera, moved to the front of the cache. On a miss, an invalid or the least
+     * recently used order is recycled and must be sorted by the caller.
+     * @param orders cache of orders
+     * @param dirty when true, all the cached orders are invalidated first (reset on return)
+     * @param cameraMatrix camera (also view) matrix (must be already inverted)
+     * @return order (valid when still up to date)
+     */
+    static Order& getOrder(std::vector<Order>& orders, bool& dirty, const glm::mat4& cameraMatrix)
+    {
+        if (dirty)
+        {
+            for (Order& order : orders)
+                order.valid = false;
+            dirty = false;
+        }
+
+        auto it = std::find_if(orders.begin(), orders.end(), [&](const Order& order)
+        {
+            return order.valid && order.camera == cameraMatrix;
+        });
+        if (it == orders.end())
+        {
+            it = std::find_if(orders.begin(), orders.end(), [](const Order& order) { return !order.valid; });
+            if (it == orders.end())
+            {
+                if (orders.size() < maxNrOfOrders)
+                    orders.emplace_back();
+                it = orders.end() - 1;
+            }
+            it->camera = cameraMatrix;
+            it->valid = false;
+        }
+        std::rotate(orders.begin(), it, it + 1);
+        return orders.front();
+    }
+
+
+    /**
+     * Sorts the solid meshes by a 64-bit state key, so that consecutive draws share as much state as possible.
+     * Key layout (MSB to LSB): texture set (16 bits), material (16 bits), geometry and LOD (16 bits), front-to-back
+     * depth (16 bits). Meshes sharing geometry and material end up adjacent, so they can be drawn as one instanced call.
+     * The order of the last few cameras is kept, so that alternating passes (e.g., shadow and main) do not re-sort.
+     * @param cameraMatrix camera (also view) matrix (must be already inverted)
+     * @return positions of the solid meshes in draw order
+     */
+    const std::vector<uint32_t>& sortSolidMeshes(const glm::mat4& cameraMatrix)
+    {
+        Order& order = getOrder(solidOrders, solidOrderDirty, cameraMatrix);
+        if (order.valid)
+            return order.elems;
+
+        std::vector<uint32_t>& solidOrder = order.elems;
+        const uint32_t size = static_cast<uint32_t>(solidMeshes.size());
+        sortKeys.resize(size);
+        solidOrder.resize(size);
+        for (uint32_t c = 0; c < size; c++)
+        {
+            const Eng::List::RenderableElem& re = solidMeshes[c];
+            const Eng::Mesh& mesh = static_cast<const Eng::Mesh&>(re.reference.get());
+            const Eng::Material& material = mesh.getMaterial();
+
+            uint32_t textureSet = 0;
+            for (uint32_t t = static_cast<uint32_t>(Eng::Texture::Type::albedo); t < static_cast<uint32_t>(Eng::Texture::Type::last); t++)
+                textureSet = textureSet * 31 + material.getTexture(static_cast<Eng::Texture::Type>(t)).getId();
+
+            const float distance = -(cameraMatrix * re.matrix[3]).z;
+            sortKeys[c] = (static_cast<uint64_t>(textureSet & 0xffff) << 48) |
+                          (static_cast<uint64_t>(material.getId() & 0xffff) << 32) |
+                          (static_cast<uint64_t>((mesh.getGeometryId() * 4 + std::min(re.lod, 3u)) & 0xffff) << 16) |
+                          (depthToKey(distance) >> 16);
+            solidOrder[c] = c;
+        }
+        radixSort(sortKeys, solidOrder, tmpKeys, tmpValues);
+
+        order.valid = true;
+        return solidOrder;
+    }
+
+
+    /**
+     * Sorts the transparent meshes back-to-front, as required by plain alpha blending. View-space distances are
+     * computed first in a tight loop (only the third row of the camera matrix is needed), then radix-sorted.
+     * @param cameraMatrix camera (also view) matrix (must be already inverted)
+     * @return positions of the transparent meshes in draw order
+     */
+    const std::vector<uint32_t>& sortTransparents(const glm::mat4& cameraMatrix)
+    {
+        Order& order = getOrder(transparentOrders, transparentOrderDirty, cameraMatrix);
+        if (order.valid)
+            return order.elems;
+
+        std::vector<uint32_t>& transparentOrder = order.elems;
+        const uint32_t size = static_cast<uint32_t>(transparents.size());
+        const glm::vec4 zRow(cameraMatrix[0][2], cameraMatrix[1][2], cameraMatrix[2][2], cameraMatrix[3][2]);
+        distances.resize(size);
+        for (uint32_t c = 0; c < size; c++)
+            distances[c] = -glm::dot(zRow, transparents[c].matrix[3]);
+
+        sortKeys.resize(size);
+        transparentOrder.resize(size);
+        for (uint32_t c = 0; c < size; c++)
+        {
+            sortKeys[c] = ~depthToKey(distances[c]); // Farthest first
+            transparentOrder[c] = c;
+        }
+        radixSort(sortKeys, transparentOrder, tmpKeys, tmpValues);
+
+        order.valid = true;
+        return transparentOrder;
+    }
+
+
+    /**
+     * Groups the visible solid meshes into batches of consecutive elements (in sorted order) sharing geometry, LOD and
+     * material, and uploads the modelview matrices of the multi-instance batches into the instance buffer.
+     * @param solidOrder positions of the solid meshes in draw order
+     * @param cameraMatrix camera (also view) matrix (must be already inverted)
+     * @param culling when true, invisible elements are skipped
+     */
+    void buildBatches(const std::vector<uint32_t>& solidOrder, const glm::mat4& cameraMatrix, bool culling)
+    {
+        // Collect visible elements in sorted order, splitting them into runs:
+        visibleOrder.clear();
+        batches.clear();
+        const Eng::Mesh* prev = nullptr;
+        for (uint32_t c : solidOrder)
+        {
+            const Eng::List::RenderableElem& re = solidMeshes[c];
+            if (culling && re.visible == false)
+                continue;
+
+            const Eng::Mesh& mesh = static_cast<const Eng::Mesh&>(re.reference.get());
+            if (prev && prev->getGeometryId() == mesh.getGeometryId() &&
+                prev->getMaterial().getId() == mesh.getMaterial().getId() &&
+                solidMeshes[visibleOrder.back()].lod == re.lod)
+                batches.back().count++;
+            else
+                batches.push_back({static_cast<uint32_t>(visibleOrder.size()), 1, 0});
+            visibleOrder.push_back(c);
+            prev = &mesh;
+        }
+
+        // Gather instance data of the runs drawn with instancing:
+        instanceMatrices.clear();
+        for (Batch& batch : batches)
+        {
+            if (batch.count < 2)
+                continue;
+            batch.baseInstance = static_cast<uint32_t>(instanceMatrices.size());
+            for (uint32_t c = batch.first; c < batch.first + batch.count; c++)
+                instanceMatrices.push_back(cameraMatrix * solidMeshes[visibleOrder[c]].matrix);
+        }
+        if (instanceMatrices.empty())
+            return;
+
+        // Upload (grow the buffer when needed):
+        const uint64_t size = instanceMatrices.size() * sizeof(glm::mat4);
+        if (instanceBuffer.getSize() < size)
+            instanceBuffer.create(size * 2, nullptr, GL_STREAM_DRAW);
+        instanceBuffer.update(size, instanceMatrices.data());
+        instanceBuffer.render(5);
+    }
+
+
+    /**
+     * Recursively adds a subtree to the list.
+     * @param parent parent of the subtree root
+     * @param node subtree root
+     * @param baseId index of the base matrix
+     */
+    void insert(const Eng::Node* parent, const Eng::Node& node, uint32_t baseId)
+    {
+        std::vector<Entry> entries;
+        collect(node, parent, baseId, entries);
+        merge(entries, baseId);
+    }
+
+
+    /**
+     * Removes the element of a slot from its array, by swapping it with the last one.
+     * @param slot slot of the element (renderable only)
+     */
+    void erase(const Slot& slot)
     {
+        auto& array = getArray(slot.category);
+        if (slot.index != array.size() - 1)
+        {
+            array[slot.index] = array.back();
+            slots[static_cast<const Eng::Node*>(&array[slot.index].reference.get())].index = slot.index;
+        }
+        array.pop_back();
+        solidOrderDirty = true;
+        transparentOrderDirty = true;
+    }
+
+
+    /**
+     * Moves the meshes whose material changed opacity (or was replaced) between the solid and transparent arrays.
+     */
+    void recategorize()
+    {
+        std::vector<const Eng::Node*> moved;
+        for (auto array : {&solidMeshes, &transparents})
+            for (const auto& re : *array)
+            {
+                const Eng::Mesh& mesh = static_cast<const Eng::Mesh&>(re.reference.get());
+                const bool transparent = mesh.getMaterial().getOpacity() < 1.0f;
+                if (transparent != (array == &transparents))
+                    moved.push_back(&mesh);
+            }
+
+        for (const Eng::Node* node : moved)
+        {
+            Slot& slot = slots.at(node);
+            const Eng::List::RenderableElem re = getArray(slot.category)[slot.index];
+            erase(slot);
+            slot.category = getCategory(*node);
+            auto& array = getArray(slot.category);
+            slot.index = static_cast<uint32_t>(array.size());
+            array.push_back(re);
+        }
+    }
+
+
+    /**
+     * Recursively removes a subtree from the list. Elements are swapped with the last one of their array. Descendants
+     * are found through the slots, as the nodes may be already released (e.g., during Container::reset()).
+     * @param node subtree root (never dereferenced)
+     */
+    void remove(const Eng::Node* node)
+    {
+        auto it = slots.find(node);
+        if (it == slots.end())
+            return;
+        const Slot slot = std::move(it->second);
+        slots.erase(it);
+
+        // Unlink from the parent:
+        auto parent = slots.find(slot.parent);
+        if (parent != slots.end())
+        {
+            auto& siblings = parent->second.children;
+            siblings.erase(std::remove(siblings.begin(), siblings.end(), node), siblings.end());
+        }
+
+        if (slot.category != Eng::List::Pass::none)
+            erase(slot);
+
+        // Parse hierarchy recursively:
+        for (const Eng::Node* n : slot.children)
+            remove(n);
+    }
+
+
+    /**
+     * Applies the queued scene graph events, in order. Called by the thread using the list, so that the callbacks
+     * (possibly invoked by other threads) never touch the arrays.
+     */
+    void applyEvents()
+    {
+        {
+            std::lock_guard<std::mutex> lock(eventMutex);
+            if (events.empty())
+                return;
+            applied.swap(events);
+            pendingAdds.clear();
+        }
+
+        for (const Event& event : applied)
+        {
+            if (event.child == nullptr)
+                continue;
+            if (event.added)
+            {
+                auto it = slots.find(event.parent);
+                if (it != slots.end())
+                    insert(event.parent, *event.child, it->second.baseId);
+            }
+            else
+                remove(event.child);
+        }
+        applied.clear();
     }
 };
 
@@ -56,6 +628,7 @@ struct Eng::List::Reserved
 ENG_API Eng::List::List() : reserved(std::make_unique<Eng::List::Reserved>())
 {
     ENG_LOG_DETAIL("[+]");
+    Eng::Node::addListener(*this);
 }
 
 
@@ -67,6 +640,7 @@ ENG_API Eng::List::List() : reserved(std::make_unique<Eng::List::Reserved>())
 ENG_API Eng::List::List(const std::string& name) : Eng::Object(name), reserved(std::make_unique<Eng::List::Reserved>())
 {
     ENG_LOG_DETAIL("[+]");
+    Eng::Node::addListener(*this);
 }
 
 
@@ -77,6 +651,8 @@ ENG_API Eng::List::List(const std::string& name) : Eng::Object(name), reserved(s
 ENG_API Eng::List::List(List&& other) : Eng::Object(std::move(other)), reserved(std::move(other.reserved))
 {
     ENG_LOG_DETAIL("[M]");
+    Eng::Node::removeListener(other);
+    Eng::Node::addListener(*this);
 }
 
 
@@ -87,6 +663,7 @@ ENG_API Eng::List::List(List&& other) : Eng::Object(std::move(other)), reserved(
 ENG_API Eng::List::~List()
 {
     ENG_LOG_DETAIL("[-]");
+    Eng::Node::removeListener(*this);
 }
 
 
@@ -96,9 +673,20 @@ ENG_API Eng::List::~List()
  */
 void ENG_API Eng::List::reset()
 {
-    reserved->renderableElem.clear();
-    reserved->nrOfLights = 0;
-    reserved->nrOfSolidMeshes = 0;
+    {
+        std::lock_guard<std::mutex> lock(reserved->eventMutex);
+        reserved->events.clear();
+        reserved->pendingAdds.clear();
+    }
+    reserved->lights.clear();
+    reserved->solidMeshes.clear();
+    reserved->transparents.clear();
+    reserved->slots.clear();
+    reserved->baseMatrices.resize(1);
+    reserved->solidOrders.clear();
+    reserved->solidOrderDirty = true;
+    reserved->transparentOrders.clear();
+    reserved->transparentOrderDirty = true;
 }
 
 
@@ -109,7 +697,7 @@ void ENG_API Eng::List::reset()
  */
 uint32_t ENG_API Eng::List::getNrOfRenderableElems() const
 {
-    return static_cast<uint32_t>(reserved->renderableElem.size());
+    return static_cast<uint32_t>(reserved->lights.size() + reserved->solidMeshes.size() + reserved->transparents.size());
 }
 
 
@@ -120,35 +708,99 @@ uint32_t ENG_API Eng::List::getNrOfRenderableElems() const
  */
 uint32_t ENG_API Eng::List::getNrOfLights() const
 {
-    return reserved->nrOfLights;
+    return static_cast<uint32_t>(reserved->lights.size());
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Gets internal list of renderable elements.
+ * Gets the number of solid meshes currently loaded in the list.
+ * @return number of loaded solid meshes
+ */
+uint32_t ENG_API Eng::List::getNrOfSolidMeshes() const
+{
+    return static_cast<uint32_t>(reserved->solidMeshes.size());
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets internal list of lights.
+ * @return list of renderable elements
+ */
+const std::vector<Eng::List::RenderableElem> ENG_API& Eng::List::getLights() const
+{
+    return reserved->lights;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets internal list of solid meshes.
+ * @return list of renderable elements
+ */
+const std::vector<Eng::List::RenderableElem> ENG_API& Eng::List::getSolidMeshes() const
+{
+    return reserved->solidMeshes;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets internal list of transparent meshes.
  * @return list of renderable elements
  */
-const std::vector<Eng::List::RenderableElem> ENG_API& Eng::List::getRenderableElems() const
+const std::vector<Eng::List::RenderableElem> ENG_API& Eng::List::getTransparents() const
 {
-    return reserved->renderableElem;
+    return reserved->transparents;
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Gets a reference to the specified element in the list. 
+ * Gets a reference to the specified element in the list. Elements are numbered lights first, then solid meshes,
+ * then transparent meshes.
  * @return element at the given position
  */
 const Eng::List::RenderableElem ENG_API& Eng::List::getRenderableElem(uint32_t elemNr) const
 {
-    return reserved->renderableElem.at(elemNr);
+    if (elemNr < reserved->lights.size())
+        return reserved->lights[elemNr];
+    elemNr -= static_cast<uint32_t>(reserved->lights.size());
+    if (elemNr < reserved->solidMeshes.size())
+        return reserved->solidMeshes[elemNr];
+    elemNr -= static_cast<uint32_t>(reserved->solidMeshes.size());
+    return reserved->transparents.at(elemNr);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Marks the specified element as visible or culled. Culled elements are skipped during rendering.
+ * @param elemNr position of the element in the list
+ * @param visible visibility flag
+ * @return TF
+ */
+bool ENG_API Eng::List::setVisible(uint32_t elemNr, bool visible)
+{
+    // Safety net:
+    if (elemNr >= getNrOfRenderableElems())
+    {
+        ENG_LOG_ERROR("Invalid params");
+        return false;
+    }
+
+    const_cast<Eng::List::RenderableElem&>(getRenderableElem(elemNr)).visible = visible;
+
+    // Done:
+    return true;
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Recursively parses the scenegraph starting at the given node and append the parsed elements to this list. 
+ * Subtrees are traversed in parallel by the job system. From then on, the subtree is tracked: nodes attached or detached later are added or removed incrementally.
  * @param node starting node
  * @param prevMatrix previous node matrix
  * @return TF
@@ -162,95 +814,302 @@ bool ENG_API Eng::List::process(const Eng::Node& node, const glm::mat4& prevMatr
         return false;
     }
 
-    RenderableElem re;
-    re.matrix = prevMatrix * node.getMatrix();
-    re.reference = node;
+    reserved->applyEvents();
 
-    // Store only renderable elements:
-    if (dynamic_cast<const Eng::Light*>(&node)) // Lights first
+    // World matrices are relative to the root: rebase them only when needed
+    glm::mat4 baseMatrix = prevMatrix;
+    if (node.getParent() != Eng::Node::empty)
+        baseMatrix = prevMatrix * glm::inverse(node.getParent().getWorldMatrix());
+    uint32_t baseId = 0;
+    if (baseMatrix != glm::mat4(1.0f))
     {
-        reserved->renderableElem.insert(reserved->renderableElem.begin(), 1, re);
-        reserved->nrOfLights++;
+        baseId = static_cast<uint32_t>(reserved->baseMatrices.size());
+        reserved->baseMatrices.push_back(baseMatrix);
     }
-    else if (dynamic_cast<const Eng::Mesh*>(&node)) // Only meshes
-    {
-        //reserved->renderableElem.insert(reserved->renderableElem.begin() + reserved->nrOfLights, 1, re);
-        //reserved->renderableElem.push_back(re);
 
+    reserved->worldVersion = Eng::Node::getWorldVersion();
 
-        if (const auto mesh = dynamic_cast<const Eng::Mesh*>(&node); mesh->getMaterial().getOpacity() < 1.0f)
-        {
-            reserved->renderableElem.push_back(re);
-        }
-        else
+    // Split the traversal at subtree boundaries: the top of the hierarchy is expanded breadth-first until there are
+    // enough subtrees to keep all the workers busy:
+    Eng::Jobs& jobs = Eng::Jobs::getInstance();
+    const size_t nrOfSubtrees = jobs.getNrOfWorkers() * 4;
+    std::vector<Reserved::Entry> top;
+    std::vector<std::pair<const Eng::Node*, const Eng::Node*>> subtrees; // Subtree roots and their parents
+    if (reserved->slots.count(&node) == 0)
+        subtrees.push_back({&node, &node.getParent()});
+    while (!subtrees.empty() && subtrees.size() < nrOfSubtrees)
+    {
+        std::vector<std::pair<const Eng::Node*, const Eng::Node*>> next;
+        for (const auto& n : subtrees)
         {
-            reserved->nrOfSolidMeshes++;
-            auto iter = reserved->renderableElem.begin() + reserved->nrOfLights;
-            reserved->renderableElem.insert(iter, 1, re);
+            reserved->visit(*n.first, n.second, baseId, top);
+            for (auto& child : n.first->getListOfChildren())
+                if (reserved->slots.count(&child.get()) == 0)
+                    next.push_back({&child.get(), n.first});
         }
+        subtrees.swap(next);
+    }
+
+    // Collect each subtree into its own buffer:
+    std::vector<std::vector<Reserved::Entry>> buffers(subtrees.size());
+    jobs.parallelFor(static_cast<uint32_t>(subtrees.size()), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t c = begin; c < end; c++)
+            reserved->collect(*subtrees[c].first, subtrees[c].second, baseId, buffers[c]);
+    });
+
+    // Merge (serially, as the node map is updated):
+    reserved->merge(top, baseId);
+    for (const auto& buffer : buffers)
+        reserved->merge(buffer, baseId);
+
+    // Done:
+    return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Brings the elements up to date with the scene graph: meshes whose material changed opacity (or was replaced) are
+ * moved between the solid and transparent arrays, matrices are refreshed if any node moved since the last call.
+ * @return TF
+ */
+bool ENG_API Eng::List::update()
+{
+    reserved->applyEvents();
+
+    // Meshes changing opacity or material switch between the solid and transparent arrays:
+    const uint64_t passVersion = Eng::Material::getPassVersion();
+    if (passVersion != reserved->passVersion)
+    {
+        reserved->recategorize();
+        reserved->passVersion = passVersion;
     }
 
-    // Parse hierarchy recursively:
-    for (auto& n : node.getListOfChildren())
-        if (process(n, re.matrix) == false)
-            return false;
+    const uint64_t version = Eng::Node::getWorldVersion();
+    if (version == reserved->worldVersion)
+        return true;
+
+    for (auto array : {&reserved->lights, &reserved->solidMeshes, &reserved->transparents})
+        Eng::Jobs::getInstance().parallelFor(static_cast<uint32_t>(array->size()), 1024, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t c = begin; c < end; c++)
+            {
+                auto& re = (*array)[c];
+                const Eng::Node& node = static_cast<const Eng::Node&>(re.reference.get());
+                re.matrix = reserved->getMatrix(node, reserved->slots.at(&node).baseId);
+            }
+        });
+    reserved->worldVersion = version;
+    reserved->solidOrderDirty = true;
+    reserved->transparentOrderDirty = true;
+
+    // Done:
+    return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Selects the level of detail of each mesh from the projected size of its bounding sphere. A mesh switches to a
+ * coarser (or finer) LOD only once its size crosses the threshold by more than lodHysteresis.
+ * @param cameraMatrix camera (also view) matrix (must be already inverted)
+ * @param projectionMatrix projection matrix
+ * @return TF
+ */
+bool ENG_API Eng::List::selectLods(const glm::mat4& cameraMatrix, const glm::mat4& projectionMatrix)
+{
+    reserved->applyEvents();
+
+    for (auto array : {&reserved->solidMeshes, &reserved->transparents})
+        for (auto& re : *array)
+        {
+            const Eng::Mesh& mesh = static_cast<const Eng::Mesh&>(re.reference.get());
+            const uint32_t nrOfLods = mesh.getNrOfLods();
+            if (nrOfLods < 2)
+                continue;
+
+            // Projected radius (relative to half the screen height, perspective projection assumed):
+            const glm::vec4 sphere = mesh.getBoundingSphere();
+            const glm::vec3 center = glm::vec3(cameraMatrix * re.matrix * glm::vec4(glm::vec3(sphere), 1.0f));
+            const float scale = glm::max(glm::length(glm::vec3(re.matrix[0])),
+                                         glm::max(glm::length(glm::vec3(re.matrix[1])), glm::length(glm::vec3(re.matrix[2]))));
+            const float distance = glm::length(center);
+            const float size = distance > sphere.w * scale ? sphere.w * scale * projectionMatrix[1][1] / distance : 1.0f;
+
+            // Hysteresis:
+            uint32_t lod = re.lod;
+            const uint32_t lodShrinking = lodForSize(size, nrOfLods, 1.0f - lodHysteresis);
+            const uint32_t lodGrowing = lodForSize(size, nrOfLods, 1.0f + lodHysteresis);
+            if (lodShrinking > lod)
+                lod = lodShrinking;
+            else if (lodGrowing < lod)
+                lod = lodGrowing;
+
+            if (lod != re.lod)
+            {
+                re.lod = lod;
+                if (array == &reserved->solidMeshes)
+                    reserved->solidOrderDirty = true;
+            }
+        }
 
     // Done:
     return true;
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Shortcut for using a camera instead of the explicit matrices.  
+ * @param camera camera to use
+ * @return TF
+ */
+bool ENG_API Eng::List::selectLods(const Eng::Camera& camera)
+{
+    return this->selectLods(glm::inverse(camera.getWorldMatrix()), camera.getProjMatrix());
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Scene graph event: adds the new child subtree if its parent is tracked by this list. Can be invoked by any thread:
+ * the event is queued and applied by the next process(), update(), selectLods() or render().
+ * @param parent parent node
+ * @param child node just attached
+ */
+void ENG_API Eng::List::nodeAdded(const Eng::Node& parent, const Eng::Node& child)
+{
+    if (!reserved)
+        return;
+    std::lock_guard<std::mutex> lock(reserved->eventMutex);
+    reserved->pendingAdds[&child] = reserved->events.size();
+    reserved->events.push_back({&parent, &child, true});
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Scene graph event: removes the child subtree if tracked by this list. Can be invoked by any thread: the event is
+ * queued and applied by the next process(), update(), selectLods() or render().
+ * @param parent parent node
+ * @param child node being detached or released
+ */
+void ENG_API Eng::List::nodeRemoved(const Eng::Node& parent, const Eng::Node& child)
+{
+    if (!reserved)
+        return;
+    std::lock_guard<std::mutex> lock(reserved->eventMutex);
+
+    // A pending insertion of the same node is canceled, as the node might be released before being collected:
+    auto it = reserved->pendingAdds.find(&child);
+    if (it != reserved->pendingAdds.end())
+    {
+        reserved->events[it->second].child = nullptr;
+        reserved->pendingAdds.erase(it);
+    }
+    reserved->events.push_back({&parent, &child, false});
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Parses the list and calls the render method of each renderable.
  * @param cameraMatrix camera (also view) matrix (must be already inverted)
  * @param projectionMatrix projection matrix
  * @param pass type of pass
+ * @param culling when true, elements marked as not visible are skipped and meshlets are culled
  * @return TF
  */
 bool ENG_API Eng::List::render(const glm::mat4& cameraMatrix, const glm::mat4& projectionMatrix,
-                               Eng::List::Pass pass) const
+                               Eng::List::Pass pass, bool culling) const
 {
-    // Define range:
-    size_t startRange = 0;
-    size_t endRange = reserved->renderableElem.size();
-
     // TODO set projection matrix in shader
 
+    reserved->applyEvents();
+
+    // Select arrays:
+    const std::vector<RenderableElem>* arrays[3] = {nullptr, nullptr, nullptr};
     switch (pass)
     {
     //////////////////
     case Pass::all: //
+        arrays[0] = &reserved->lights;
+        arrays[1] = &reserved->solidMeshes;
+        arrays[2] = &reserved->transparents;
         break;
 
     /////////////////////
     case Pass::lights: //  
-        endRange = reserved->nrOfLights;
+        arrays[0] = &reserved->lights;
         break;
 
     /////////////////////
     case Pass::meshes: //
-        startRange = reserved->nrOfLights;
-        endRange = reserved->nrOfLights + reserved->nrOfSolidMeshes;
+        arrays[0] = &reserved->solidMeshes;
         break;
 
     //////////////////////////
     case Pass::transparents: //
-        startRange = reserved->nrOfLights + reserved->nrOfSolidMeshes;
+        arrays[0] = &reserved->transparents;
         break;
 
     case Pass::meshes_and_transparents:
-        startRange = reserved->nrOfLights;
+        arrays[0] = &reserved->solidMeshes;
+        arrays[1] = &reserved->transparents;
         break;
     }
 
-    // Iterate through the range:
-    for (size_t c = startRange; c < endRange; c++)
-    {
-        RenderableElem& re = reserved->renderableElem.at(c);
-        glm::mat4 finalMatrix = cameraMatrix * re.matrix;
-        re.reference.get().render(0, &finalMatrix);
-    }
+    // Redundant binds are skipped within this call only (other code can change the GL state in between):
+    Eng::Material::reset();
+    Eng::Texture::reset();
+    Eng::Vao::reset();
+
+    // Iterate through the arrays:
+    for (auto array : arrays)
+        if (array)
+        {
+            // Solid meshes are drawn following the state-sorted queue, transparent ones back-to-front:
+            const std::vector<uint32_t>* order = nullptr;
+            if (array == &reserved->solidMeshes)
+                order = &reserved->sortSolidMeshes(cameraMatrix);
+            else if (array == &reserved->transparents)
+                order = &reserved->sortTransparents(cameraMatrix);
+            // Solid meshes sharing geometry and material are drawn with a single instanced call:
+            if (array == &reserved->solidMeshes)
+            {
+                reserved->buildBatches(*order, cameraMatrix, culling);
+                for (const Reserved::Batch& batch : reserved->batches)
+                {
+                    const RenderableElem& re = (*array)[reserved->visibleOrder[batch.first]];
+                    const Eng::Mesh& mesh = static_cast<const Eng::Mesh&>(re.reference.get());
+                    if (batch.count > 1)
+                        mesh.renderInstanced(batch.count, batch.baseInstance, re.lod);
+                    else
+                    {
+                        glm::mat4 finalMatrix = cameraMatrix * re.matrix;
+                        if (culling && re.lod == 0 && mesh.getNrOfMeshlets())
+                            mesh.renderMeshlets(finalMatrix, projectionMatrix);
+                        else
+                            mesh.render(re.lod, &finalMatrix);
+                    }
+                }
+                continue;
+            }
+
+            for (size_t c = 0; c < array->size(); c++)
+            {
+                const RenderableElem& re = (*array)[order ? (*order)[c] : c];
+                if (culling && re.visible == false)
+                    continue;
+                glm::mat4 finalMatrix = cameraMatrix * re.matrix;
+                re.reference.get().render(re.lod, &finalMatrix);
+            }
+        }
+
+    Eng::Material::reset();
+    Eng::Texture::reset();
+    Eng::Vao::reset();
 
     // Done:
     return true;
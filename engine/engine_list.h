@@ -9,9 +9,10 @@
 
 
 /**
- * @brief Class for storing a list of objects after the scenegraph traversal.
+ * @brief Class for storing a list of objects after the scenegraph traversal. Once processed, the list follows the 
+ *        changes of the scene graph incrementally: lights, solid meshes and transparent meshes are kept in separate arrays.
  */
-class ENG_API List final : public Eng::Object
+class ENG_API List final : public Eng::Object, public Eng::Node::Listener
 {
 //////////
 public: //
@@ -19,6 +20,8 @@ public: //
 
    // Special values:
    static List empty;   
+   constexpr static float lodThreshold = 0.25f;    ///< Projected radius (relative to half the screen height) under which LOD 1 is used, halved for each next LOD
+   constexpr static float lodHysteresis = 0.1f;    ///< Relative margin around each threshold, to avoid LOD popping back and forth
 
    
    /**
@@ -47,12 +50,14 @@ public: //
    {
       std::reference_wrapper<const Eng::Object> reference;  ///< Reference to the original object
       glm::mat4 matrix;                                     ///< Final position in world coordinates     
+      bool visible;                                         ///< False when culled (e.g., by occlusion tests)
+      uint32_t lod;                                         ///< Level of detail to draw (meshes only)
 
 
       /**
        * Constructor. 
        */
-      RenderableElem() : reference{ Eng::Object::empty }, matrix{ 1.0f }
+      RenderableElem() : reference{ Eng::Object::empty }, matrix{ 1.0f }, visible{ true }, lod{ 0 }
       {}
    };
 
@@ -64,18 +69,29 @@ public: //
    virtual ~List();         
    
    // Get/set:
-   const std::vector<Eng::List::RenderableElem> &getRenderableElems() const;
+   const std::vector<Eng::List::RenderableElem> &getLights() const;
+   const std::vector<Eng::List::RenderableElem> &getSolidMeshes() const;
+   const std::vector<Eng::List::RenderableElem> &getTransparents() const;
    const Eng::List::RenderableElem &getRenderableElem(uint32_t elemNr) const;
    uint32_t getNrOfRenderableElems() const;
    uint32_t getNrOfLights() const;
+   uint32_t getNrOfSolidMeshes() const;
+   bool setVisible(uint32_t elemNr, bool visible);
      
    // Scene graph traversal:
    void reset();
    bool process(const Eng::Node &node, const glm::mat4 &prevMatrix = glm::mat4(1.0f));   
+   bool update();
+   bool selectLods(const Eng::Camera &camera);
+   bool selectLods(const glm::mat4 &cameraMatrix, const glm::mat4 &projectionMatrix);
+
+   // Events:
+   void nodeAdded(const Eng::Node &parent, const Eng::Node &child) override;
+   void nodeRemoved(const Eng::Node &parent, const Eng::Node &child) override;
 
    // Rendering:   
    bool render(const Eng::Camera &camera, Pass pass = Pass::all) const;
-   bool render(const glm::mat4 &cameraMatrix, const glm::mat4 &projectionMatrix, Pass pass = Pass::all) const;
+   bool render(const glm::mat4 &cameraMatrix, const glm::mat4 &projectionMatrix, Pass pass = Pass::all, bool culling = true) const;
 
 
 ///////////
@@ -11,13 +11,22 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM core
+
    // Main include:
    #include "engine.h"
 
    // C/C++ libs:
    #include <stdarg.h>
-   #include <stdio.h>   
-   #include <fstream>    
+   #include <stdio.h>
+   #include <fstream>
+   #include <atomic>
+   #include <thread>
+   #include <mutex>
+   #include <condition_variable>
+   #include <chrono>
+   #include <algorithm>
 
 
 
@@ -25,30 +34,174 @@
 // RESERVED STRUCTURES //
 /////////////////////////
 
+/**
+ * @brief Pending message, filled by the logging thread and consumed by the writer thread.
+ */
+struct alignas(64) LogRecord
+{
+   std::atomic<uint64_t> sequence;        ///< Ring position this record is ready for (Vyukov's bounded queue)
+   Eng::Log::level lvl;
+   int32_t codeLine;
+   const char *fileName;                  ///< Points to a string literal, so it can be formatted later
+   const char *functionName;              ///< Ditto
+   char *longText;                        ///< Heap copy of the message when it does not fit into text
+   char text[Eng::Log::recordSize - 40];
+};
+
+
 /**
  * @brief Log static reserved structure.
  */
 struct Eng::Log::StaticReserved
 {
-   std::ofstream outputFile;              ///< Textual output file   
+   std::ofstream outputFile;              ///< Textual output file
    CustomCallbackProto customCallback;    ///< Optional callback invoked after each message
 
+   // Ring:
+   std::unique_ptr<LogRecord[]> ring;
+   alignas(64) std::atomic<uint64_t> writePos;   ///< Next position to be claimed by a producer
+   alignas(64) std::atomic<uint64_t> readPos;    ///< Next position to be consumed by the writer
+
+   // Writer:
+   std::thread writer;
+   std::atomic<bool> running;
+   std::mutex mutex;                      ///< Protects the sleeping writer and synchronous output
+   std::condition_variable wakeUp;
+   std::string batch;                     ///< Output accumulated by the writer
+
 
    /**
     * Constructor.
     */
-   StaticReserved() : customCallback{ nullptr }
-   {}
+   StaticReserved() : customCallback{ nullptr }, ring{ new LogRecord[Eng::Log::ringSize] }, writePos{ 0 }, readPos{ 0 },
+                      running{ false }
+   {
+      for (uint32_t c = 0; c < Eng::Log::ringSize; c++)
+      {
+         ring[c].sequence.store(c, std::memory_order_relaxed);
+         ring[c].longText = nullptr;
+      }
+   }
+
+
+   /**
+    * Appends a formatted message (prefix, text and newline) to the batch.
+    * @param lvl level of log
+    * @param fileName name of the file invoking the log
+    * @param functionName name of the function invoking the log
+    * @param codeLine line of code invoking the log
+    * @param text message
+    */
+   void format(Eng::Log::level lvl, const char *fileName, const char *functionName, int32_t codeLine, const char *text)
+   {
+      char prefix[512];
+      switch (lvl)
+      {
+         case level::plain:   prefix[0] = '\0'; break;
+         case level::info:    snprintf(prefix, sizeof(prefix), "%s ", "[*]"); break;
+         case level::warning: snprintf(prefix, sizeof(prefix), "%s [%s] ", "[?]", functionName); break;
+         case level::error:   snprintf(prefix, sizeof(prefix), "%s [%s, %s:%d] ", "[!]", fileName, functionName, codeLine); break;
+         case level::debug:
+         case level::detail:  snprintf(prefix, sizeof(prefix), "%s [%s:%d] ", "[D]", functionName, codeLine); break;
+         default:             prefix[0] = '\0'; break;
+      }
+      batch += prefix;
+      batch += text;
+      batch += '\n';
+   }
+
+
+   /**
+    * Writes the batch to file and console.
+    */
+   void write()
+   {
+      if (batch.empty())
+         return;
+      outputFile.write(batch.data(), batch.size());
+      outputFile.flush();
+      std::cout.write(batch.data(), batch.size());
+      std::cout.flush();
+      batch.clear();
+   }
+
+
+   /**
+    * Consumes the pending records (writer side).
+    * @return number of records consumed
+    */
+   uint64_t drain()
+   {
+      uint64_t nrOfRecords = 0;
+      uint64_t pos = readPos.load(std::memory_order_relaxed);
+      for (;;)
+      {
+         LogRecord &record = ring[pos & (Eng::Log::ringSize - 1)];
+         if (record.sequence.load(std::memory_order_acquire) != pos + 1)
+            break;
+
+         char *text = record.longText ? record.longText : record.text;
+         format(record.lvl, record.fileName, record.functionName, record.codeLine, text);
+         if (customCallback)
+            customCallback(text, record.lvl, nullptr);
+         if (record.longText)
+         {
+            delete [] record.longText;
+            record.longText = nullptr;
+         }
+
+         // Release the slot to the producers:
+         record.sequence.store(pos + Eng::Log::ringSize, std::memory_order_release);
+         readPos.store(++pos, std::memory_order_release);
+         nrOfRecords++;
+      }
+      write();
+      return nrOfRecords;
+   }
+
+
+   /**
+    * Writer thread main loop: drains the ring in batches, sleeping briefly when idle.
+    */
+   void run()
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (running.load(std::memory_order_acquire))
+      {
+         if (drain())
+            continue;
+         wakeUp.wait_for(lock, std::chrono::milliseconds(10));
+      }
+   }
 };
 
 
 
 ////////////
 // STATIC //
-////////////   
+////////////
 
    // Reserved data:
-   Eng::Log::StaticReserved *Eng::Log::staticReserved = nullptr; // No unique_ptr, as the pointer might go out of scope *before* the atexit invocation!
+   // Runtime levels:
+   std::atomic<uint32_t> Eng::Log::thresholds[static_cast<uint32_t>(Eng::Log::subsystem::last)] = {
+      { static_cast<uint32_t>(Eng::Log::debugLvl) }, { static_cast<uint32_t>(Eng::Log::debugLvl) }, 
+      { static_cast<uint32_t>(Eng::Log::debugLvl) }, { static_cast<uint32_t>(Eng::Log::debugLvl) }, 
+      { static_cast<uint32_t>(Eng::Log::debugLvl) }, { static_cast<uint32_t>(Eng::Log::debugLvl) }, 
+      { static_cast<uint32_t>(Eng::Log::debugLvl) } };
+
+      std::atomic<Eng::Log::StaticReserved *> Eng::Log::staticReserved{ nullptr }; // Never deleted, as other threads may still be logging at exit (see free())
+
+
+
+/**
+ * Gets the mutex serializing the lazy initialization.
+ * @return mutex
+ */
+static std::mutex &getInitMutex()
+{
+   static std::mutex initMutex;
+   return initMutex;
+}
 
 
 
@@ -70,24 +223,30 @@ bool ENG_API Eng::Log::init()
       return false;
    }
 
-   // Allocate and reset:
-   staticReserved = new Eng::Log::StaticReserved();
+   // Allocate and reset (published once ready, as other threads may be logging meanwhile):
+   Eng::Log::StaticReserved *sr = new Eng::Log::StaticReserved();
 
    // Add shutdown hook:
    atexit([]()
-   {         
+   {
       if (Eng::Object::getNrOfObjects() != 0)
          ENG_LOG_ERROR("Memory leak detected (parity check returned %d)", Eng::Object::getNrOfObjects());
       Eng::Log::free();
    });
 
-   staticReserved->outputFile.open(filename);
-   if (!staticReserved->outputFile.is_open())
+   sr->outputFile.open(filename);
+   if (!sr->outputFile.is_open())
    {
       std::cout << "[!] Unable to open output log file '" << filename << "'" << std::endl;
+      staticReserved = sr;
       return false;
    }
 
+   // Start writer:
+   sr->running = true;
+   sr->writer = std::thread(&Eng::Log::StaticReserved::run, sr);
+   staticReserved = sr;
+
    // Done:
    return true;
 }
@@ -106,10 +265,14 @@ bool ENG_API Eng::Log::free()
 
    ENG_LOG_DEBUG("[-] Logging completed");
 
-   // Release resources:
-   staticReserved->outputFile.close();
-   delete staticReserved;
-   staticReserved = nullptr;
+   // Stop the writer and close the file. The structure itself is kept, so that threads still logging never access 
+   // freed memory (their messages only reach the console from now on):
+   setAsynchronous(false);
+   StaticReserved &sr = *staticReserved;
+   std::lock_guard<std::mutex> lock(sr.mutex);
+   if (!sr.outputFile.is_open())
+      return false;
+   sr.outputFile.close();
 
    // Done:
    return true;
@@ -118,82 +281,114 @@ bool ENG_API Eng::Log::free()
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Log a message. Static components are lazy-loaded at first usage.
+ * Log a message. Static components are lazy-loaded at first usage. The message is formatted on the calling thread and
+ * queued for the writer thread (or written directly when logging is synchronous).
  * @param lvl level of log (use level enum types)
- * @param fileName name of the file invoking the log
- * @param functionName name of the function invoking the log
+ * @param fileName name of the file invoking the log (must be a string literal)
+ * @param functionName name of the function invoking the log (must be a string literal)
  * @param text message, with custom series of params
- * @warning race conditions when run concurrently
+ * @return false for errors, true otherwise
  */
 bool ENG_API Eng::Log::log(level lvl, const char *fileName, const char *functionName, int32_t codeLine, const char *text, ...)
 {
-   // Init at first usage:  
+   // Unnecessary?
+   const bool returnMessage = lvl != level::error;
+   if (lvl > Eng::Log::debugLvl)
+      return returnMessage;
+
+   // Init at first usage:
    if (staticReserved == nullptr)
-      if (Log::init())
-         ENG_LOG_DEBUG("[+] Logging to file '%s' enabled", filename);
-      else
-         std::cout << "[!] No logging to file for this session" << std::endl;
+   {
+      std::lock_guard<std::mutex> lock(getInitMutex());
+      if (staticReserved == nullptr)
+      {
+         if (Log::init())
+            ENG_LOG_DEBUG("[+] Logging to file '%s' enabled", filename);
+         else
+            std::cout << "[!] No logging to file for this session" << std::endl;
+      }
+   }
+   StaticReserved &sr = *staticReserved;
 
-   // Retrieve string:
-   char buffer[Log::maxLength];
+   // Synchronous output (records queued by other threads are written first, to keep the order):
    va_list list;
+   if (!sr.running.load(std::memory_order_acquire))
+   {
+      char *buffer = new char[Log::maxLength];
+      va_start(list, text);
+      vsnprintf(buffer, Log::maxLength, text, list);
+      va_end(list);
+
+      std::lock_guard<std::mutex> lock(sr.mutex);
+      sr.drain();
+      sr.format(lvl, fileName, functionName, codeLine, buffer);
+      sr.write();
+      if (sr.customCallback)
+         sr.customCallback(buffer, lvl, nullptr);
+      delete [] buffer;
+      return returnMessage;
+   }
+
+   // Claim a record (waiting for the writer when the ring is full, or draining it when the writer was stopped):
+   uint64_t pos = sr.writePos.load(std::memory_order_relaxed);
+   LogRecord *record;
+   for (;;)
+   {
+      record = &sr.ring[pos & (Log::ringSize - 1)];
+      const int64_t diff = static_cast<int64_t>(record->sequence.load(std::memory_order_acquire)) - static_cast<int64_t>(pos);
+      if (diff == 0)
+      {
+         if (sr.writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
+      }
+      else if (diff < 0)
+      {
+         if (sr.running.load(std::memory_order_acquire))
+         {
+            sr.wakeUp.notify_one();
+            std::this_thread::yield();
+         }
+         else
+         {
+            std::lock_guard<std::mutex> lock(sr.mutex);
+            sr.drain();
+         }
+         pos = sr.writePos.load(std::memory_order_relaxed);
+      }
+      else
+         pos = sr.writePos.load(std::memory_order_relaxed);
+   }
 
-   // Get params:
+   // Fill it:
+   record->lvl = lvl;
+   record->codeLine = codeLine;
+   record->fileName = fileName;
+   record->functionName = functionName;
    va_start(list, text);
-   vsprintf(buffer, text, list);
+   const int length = vsnprintf(record->text, sizeof(record->text), text, list);
    va_end(list);
-
-   // Set values according to kind:
-   const uint32_t maxPrefixSize = Log::maxLength;
-   char prefix[maxPrefixSize];
-   bool returnMessage = true;
-   switch (lvl)
-   {
-      /////////////////////
-      case level::plain: //
-         sprintf(prefix, "%s", "");
-         returnMessage = true;
-         break;
-
-      ////////////////////
-      case level::info: //
-         sprintf(prefix, "%s ", "[*]");
-         returnMessage = true;
-         break;
-
-      ///////////////////////
-      case level::warning: //
-         sprintf(prefix, "%s [%s] ", "[?]", functionName);
-         returnMessage = true;
-         break;
-
-      /////////////////////
-      case level::error: //
-         sprintf(prefix, "%s [%s, %s:%d] ", "[!]", fileName, functionName, codeLine);
-         returnMessage = false;
-         break;
-
-      //////////////////////
-      case level::debug:  //
-      case level::detail: //
-         sprintf(prefix, "%s [%s:%d] ", "[D]", functionName, codeLine);
-         returnMessage = true;
-         break;
+   if (length >= static_cast<int>(sizeof(record->text)))
+   {
+      const uint32_t size = std::min(static_cast<uint32_t>(length) + 1, Log::maxLength);
+      record->longText = new char[size];
+      va_start(list, text);
+      vsnprintf(record->longText, size, text, list);
+      va_end(list);
    }
 
-   // Unnecessary?
-   if (lvl > Eng::Log::debugLvl)
-      return returnMessage;
-
-   // To file:
-   staticReserved->outputFile << prefix << buffer << std::endl;
+   // Publish it:
+   record->sequence.store(pos + 1, std::memory_order_release);
+   if (lvl <= level::warning)
+      sr.wakeUp.notify_one();
 
-   // To console:
-   std::cout << prefix << buffer << std::endl;
-
-   // Custom callback?
-   if (staticReserved->customCallback)
-      staticReserved->customCallback(buffer, lvl, nullptr);
+   // The writer may have been stopped meanwhile (after its last drain): write the record here, then. Pairs with the
+   // fence in setAsynchronous(), so that either this thread sees the writer stopped or its final drain sees the record:
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if (!sr.running.load(std::memory_order_relaxed))
+   {
+      std::lock_guard<std::mutex> lock(sr.mutex);
+      sr.drain();
+   }
 
    // Done:
    return returnMessage;
@@ -202,19 +397,128 @@ bool ENG_API Eng::Log::log(level lvl, const char *fileName, const char *function
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Sets an optional callback that is triggered when a message occurs.
+ * Sets an optional callback that is triggered when a message occurs. When logging is asynchronous, the callback is
+ * invoked on the writer thread.
  * @param cb custom callback (nullptr to disable)
  */
 void ENG_API Eng::Log::setCustomCallback(CustomCallbackProto cb)
 {
-   // Init at first usage:  
+   // Init at first usage:
    if (staticReserved == nullptr)
-      if (Log::init())
-         ENG_LOG_DEBUG("[+] Logging to file '%s' enabled", filename);
-      else
-         std::cout << "[!] No logging to file for this session" << std::endl;
+   {
+      std::lock_guard<std::mutex> lock(getInitMutex());
+      if (staticReserved == nullptr)
+      {
+         if (Log::init())
+            ENG_LOG_DEBUG("[+] Logging to file '%s' enabled", filename);
+         else
+            std::cout << "[!] No logging to file for this session" << std::endl;
+      }
+   }
+
+   // Set it (the writer holds the mutex while invoking it):
+   StaticReserved &sr = *staticReserved;
+   std::lock_guard<std::mutex> lock(sr.mutex);
+   sr.customCallback = cb;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Starts or stops the writer thread. When stopped, pending messages are written and further messages are written
+ * directly by the calling thread. To be called from a single thread (e.g., stop before unloading the engine).
+ * @param enabled true for asynchronous logging
+ */
+void ENG_API Eng::Log::setAsynchronous(bool enabled)
+{
+   if (staticReserved == nullptr)
+      return;
+   StaticReserved &sr = *staticReserved;
+   if (enabled == sr.running.load())
+      return;
+
+   if (enabled)
+   {
+      sr.running = true;
+      sr.writer = std::thread(&Eng::Log::StaticReserved::run, &sr);
+   }
+   else
+   {
+      sr.running = false;
+      sr.wakeUp.notify_one();
+      if (sr.writer.joinable())
+         sr.writer.join();
+
+      // Write what is still pending (records published later are written by their producers, see log()):
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      std::lock_guard<std::mutex> lock(sr.mutex);
+      sr.drain();
+   }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns true when messages are written by the writer thread.
+ * @return TF
+ */
+bool ENG_API Eng::Log::isAsynchronous()
+{
+   const StaticReserved *sr = staticReserved;
+   return sr && sr->running.load();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Waits until all the messages queued so far have been written.
+ */
+void ENG_API Eng::Log::flush()
+{
+   StaticReserved *reserved = staticReserved;
+   if (reserved == nullptr)
+      return;
+   StaticReserved &sr = *reserved;
+
+   const uint64_t target = sr.writePos.load(std::memory_order_acquire);
+   while (sr.running.load(std::memory_order_acquire) && sr.readPos.load(std::memory_order_acquire) < target)
+   {
+      sr.wakeUp.notify_one();
+      std::this_thread::yield();
+   }
+}
 
-   // Release resources:
-   staticReserved->customCallback = cb;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Sets the most verbose level logged for a subsystem. Levels above debugLvl are stripped at compile time and stay 
+ * disabled regardless.
+ * @param sub subsystem
+ * @param lvl level (level::none to mute the subsystem)
+ */
+void ENG_API Eng::Log::setLevel(subsystem sub, level lvl)
+{
+   if (sub >= subsystem::last || lvl >= level::last)
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return;
+   }
+   thresholds[static_cast<uint32_t>(sub)].store(static_cast<uint32_t>(lvl), std::memory_order_relaxed);
 }
 
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the most verbose level logged for a subsystem.
+ * @param sub subsystem
+ * @return level
+ */
+Eng::Log::level ENG_API Eng::Log::getLevel(subsystem sub)
+{
+   if (sub >= subsystem::last)
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return level::none;
+   }
+   return static_cast<level>(thresholds[static_cast<uint32_t>(sub)].load(std::memory_order_relaxed));
+}
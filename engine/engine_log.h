@@ -14,7 +14,7 @@
 
    // Macros for logging (including method and lines):         
    #define __FILENAME__                 (strrchr(__FILE__, '\\') ? strrchr(__FILE__, '\\') + 1 : __FILE__)                 ///< Commodity macro for getting the filename only
-   #define ENG_LOG(kind, message, ...)  Eng::Log::log(kind, __FILENAME__, __FUNCTION__, __LINE__, message, ##__VA_ARGS__)  ///< More or less verbose logging command          
+   #define ENG_LOG(kind, message, ...)  (Eng::Log::isEnabled(kind, Eng::Log::subsystem::ENG_LOG_SUBSYSTEM) ? Eng::Log::log(kind, __FILENAME__, __FUNCTION__, __LINE__, message, ##__VA_ARGS__) : (kind) != Eng::Log::level::error)  ///< More or less verbose logging command (arguments are not evaluated when filtered out)
    #define ENG_LOG_ERROR(message, ...)  ENG_LOG(Eng::Log::level::error, message, ##__VA_ARGS__)
    #define ENG_LOG_WARN(message, ...)   ENG_LOG(Eng::Log::level::warning, message, ##__VA_ARGS__)
    #define ENG_LOG_PLAIN(message, ...)  ENG_LOG(Eng::Log::level::plain, message, ##__VA_ARGS__)            
@@ -22,10 +22,25 @@
    #define ENG_LOG_DEBUG(message, ...)  ENG_LOG(Eng::Log::level::debug, message, ##__VA_ARGS__)
    #define ENG_LOG_DETAIL(message, ...) ENG_LOG(Eng::Log::level::detail, message, ##__VA_ARGS__)      
 
+   // Subsystem of the messages logged by a source file (define it before including engine.h):
+#ifndef ENG_LOG_SUBSYSTEM
+   #define ENG_LOG_SUBSYSTEM app
+#endif
+
+   // Most verbose level compiled in (messages above it are stripped at compile time):
+#ifndef ENG_LOG_MAX_LEVEL
+   #ifdef _DEBUG
+      #define ENG_LOG_MAX_LEVEL debug
+   #else
+      #define ENG_LOG_MAX_LEVEL info
+   #endif
+#endif
+
 
 
 /**
- * @brief Logging facilities. Static components are lazy-loaded at first usage. Beware that it is not thread-safe yet.
+ * @brief Logging facilities. Static components are lazy-loaded at first usage. Messages are formatted on the calling 
+ *        thread into a lock-free ring and written to file and console in batches by a background writer thread.
  */
 class ENG_API Log final
 {
@@ -36,6 +51,8 @@ public: //
    // Constants:
    static constexpr uint32_t maxLength = 65536;                   ///< Maximum size of a log message
    static constexpr const char filename[] = "engine.log";         ///< Output logging filename
+   static constexpr uint32_t ringSize = 4096;                     ///< Nr. of pending messages (power of two)
+   static constexpr uint32_t recordSize = 256;                    ///< Bytes per pending message, longer ones spill to the heap
 
 
    /**
@@ -53,11 +70,23 @@ public: //
       last,          ///< Terminator
    };
 
-#ifdef _DEBUG
-   static constexpr const level debugLvl = level::debug;    ///< Logging message level
-#else
-   static constexpr const level debugLvl = level::info;    ///< Logging message level
-#endif
+   static constexpr const level debugLvl = level::ENG_LOG_MAX_LEVEL;    ///< Logging message level
+
+
+   /**
+    * @brief Logging subsystems, each with its own runtime level.
+    */
+   enum class subsystem : uint32_t
+   {
+      app,           ///< Application code (default)
+      core,          ///< Context, logging and object management
+      resource,      ///< Buffers, shaders and framebuffers
+      texture,       ///< Textures and bitmaps
+      scene,         ///< Scene graph, materials and render lists
+      pipeline,      ///< Rendering pipelines
+      loader,        ///< File formats and scene loading
+      last,          ///< Terminator
+   };
 
    // Const/dest:
    Log() = delete;
@@ -69,17 +98,43 @@ public: //
    // Parser proto:
    typedef bool(*CustomCallbackProto)(char *msg, level lvl, void *data);
 
+   // Filtering:
+   static void setLevel(subsystem sub, level lvl);
+   static level getLevel(subsystem sub);
+
+
+   /**
+    * Returns true when a message of the given level and subsystem is to be logged. Levels above debugLvl are 
+    * rejected at compile time, the others with a single load of the subsystem threshold.
+    * @param lvl level of log
+    * @param sub subsystem
+    * @return TF
+    */
+   static inline bool isEnabled(level lvl, subsystem sub)
+   {
+      return lvl <= debugLvl && 
+             static_cast<uint32_t>(lvl) <= thresholds[static_cast<uint32_t>(sub)].load(std::memory_order_relaxed);
+   }
+
    // Get/set:
    static void setCustomCallback(CustomCallbackProto cb);
+   static void setAsynchronous(bool enabled);
+   static bool isAsynchronous();
+
+   // Output:
+   static void flush();
 
 
 ///////////
 private: //
 ///////////
 
+   // Runtime levels (per subsystem):
+   static std::atomic<uint32_t> thresholds[static_cast<uint32_t>(subsystem::last)];
+
    // Reserved:
    struct StaticReserved;
-   static StaticReserved *staticReserved;
+   static std::atomic<StaticReserved *> staticReserved;
 
    // Init/free:
    static bool init();
@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM core
+
    // Main include:
    #include "engine.h"
 
@@ -18,14 +21,91 @@
    #include <GL/glew.h>
    #include <GLFW/glfw3.h>
 
+   // C/C++:
+   #include <algorithm>
+   #include <deque>
+   #include <limits>
+   #include <mutex>
+
 
 
 ////////////
 // STATIC //
 ////////////
 
-   // Keep track of created instances:
-   std::list<std::reference_wrapper<Eng::Managed>> allManaged;
+/**
+ * @brief OpenGL name waiting for the GPU to be done with it.
+ */
+struct PendingRelease
+{
+   Eng::Managed::Resource type;
+   GLuint oglId;
+   uint64_t frame;               ///< Frame during which the name was released
+};
+
+
+/**
+ * @brief Fence signalling the completion of the commands issued up to the end of a frame.
+ */
+struct ReleaseFence
+{
+   GLsync oglSync;
+   uint64_t frame;
+};
+
+   // Special values:
+   constexpr uint32_t noSlot = std::numeric_limits<uint32_t>::max();
+
+   // Keep track of initialized instances (each one stores its own slot, for O(1) removal):
+   std::vector<Eng::Managed *> allManaged;
+   std::recursive_mutex managedMutex;     ///< Protects the registry, the release queue and the accounting
+
+   // Deferred deletion queues:
+   std::deque<PendingRelease> pendingReleases;
+   std::deque<ReleaseFence> releaseFences;
+   uint64_t releaseFrame = 0;
+
+   // Device memory accounting:
+   uint64_t allocatedMemory[static_cast<uint32_t>(Eng::Managed::MemoryType::last)] = {};
+   uint64_t peakMemory[static_cast<uint32_t>(Eng::Managed::MemoryType::last)] = {};
+   uint64_t allocatedMemoryTotal = 0;
+   uint64_t peakMemoryTotal = 0;
+   uint64_t memoryBudget = 0;      ///< 0 for no budget
+   bool memoryBudgetExceeded = false;
+
+
+
+/**
+ * Deletes the given OpenGL names, batched per kind.
+ * @param first first pending entry
+ * @param last end of the pending entries
+ */
+static void deleteNames(std::deque<PendingRelease>::const_iterator first, std::deque<PendingRelease>::const_iterator last)
+{
+   std::vector<GLuint> ids[static_cast<uint32_t>(Eng::Managed::Resource::last)];
+   for (auto it = first; it != last; ++it)
+      ids[static_cast<uint32_t>(it->type)].push_back(it->oglId);
+
+   for (uint32_t c = 0; c < static_cast<uint32_t>(Eng::Managed::Resource::last); c++)
+   {
+      const std::vector<GLuint> &names = ids[c];
+      if (names.empty())
+         continue;
+      const GLsizei nrOfNames = static_cast<GLsizei>(names.size());
+
+      switch (static_cast<Eng::Managed::Resource>(c))
+      {
+         case Eng::Managed::Resource::buffer:       glDeleteBuffers(nrOfNames, names.data()); break;
+         case Eng::Managed::Resource::texture:      glDeleteTextures(nrOfNames, names.data()); break;
+         case Eng::Managed::Resource::vertexArray:  glDeleteVertexArrays(nrOfNames, names.data()); break;
+         case Eng::Managed::Resource::framebuffer:  glDeleteFramebuffers(nrOfNames, names.data()); break;
+         case Eng::Managed::Resource::renderbuffer: glDeleteRenderbuffers(nrOfNames, names.data()); break;
+         case Eng::Managed::Resource::program:      for (GLuint id : names) glDeleteProgram(id); break;
+         case Eng::Managed::Resource::shader:       for (GLuint id : names) glDeleteShader(id); break;
+         default: break;
+      }
+   }
+}
 
 
 
@@ -39,13 +119,76 @@
 struct Eng::Managed::Reserved
 {  
    bool initialized;    ///< True when the object is allocated on the device 
+   uint32_t slot;       ///< Position in the list of initialized instances
+   Eng::Managed::MemoryType memoryType;
+   uint64_t memoryUsage;   ///< Device memory accounted to the object, in bytes
 
 
    /**
     * Constructor.
     */
-   Reserved() : initialized{ false }
+   Reserved() : initialized{ false }, slot{ noSlot }, memoryType{ Eng::Managed::MemoryType::texture }, memoryUsage{ 0 }
    {}
+
+
+   /**
+    * Replaces the device memory accounted to the owner, updating totals and high-water marks.
+    * @param type memory category
+    * @param nrOfBytes new size in bytes
+    */
+   void account(Eng::Managed::MemoryType type, uint64_t nrOfBytes)
+   {
+      std::lock_guard<std::recursive_mutex> lock(managedMutex);
+      // Remove the previous amount:
+      allocatedMemory[static_cast<uint32_t>(memoryType)] -= memoryUsage;
+      allocatedMemoryTotal -= memoryUsage;
+
+      // Add the new one:
+      memoryType = type;
+      memoryUsage = nrOfBytes;
+      uint64_t &allocated = allocatedMemory[static_cast<uint32_t>(type)];
+      allocated += nrOfBytes;
+      allocatedMemoryTotal += nrOfBytes;
+      peakMemory[static_cast<uint32_t>(type)] = std::max(peakMemory[static_cast<uint32_t>(type)], allocated);
+
+      peakMemoryTotal = std::max(peakMemoryTotal, allocatedMemoryTotal);
+
+      // Check budget (warn once per crossing):
+      const bool exceeded = memoryBudget && allocatedMemoryTotal > memoryBudget;
+      if (exceeded && !memoryBudgetExceeded)
+         ENG_LOG_WARN("Device memory budget exceeded (%llu/%llu bytes)", allocatedMemoryTotal, memoryBudget);
+      memoryBudgetExceeded = exceeded;
+   }
+
+
+   /**
+    * Adds the owner to the list of initialized instances.
+    * @param owner managed object owning this structure
+    */
+   void track(Eng::Managed *owner)
+   {
+      std::lock_guard<std::recursive_mutex> lock(managedMutex);
+      if (slot != noSlot)
+         return;
+      slot = static_cast<uint32_t>(allManaged.size());
+      allManaged.push_back(owner);
+   }
+
+
+   /**
+    * Removes the owner from the list of initialized instances, moving the last one into its slot.
+    */
+   void untrack()
+   {
+      std::lock_guard<std::recursive_mutex> lock(managedMutex);
+      if (slot == noSlot)
+         return;
+      Eng::Managed *moved = allManaged.back();
+      allManaged[slot] = moved;
+      moved->reserved->slot = slot;
+      allManaged.pop_back();
+      slot = noSlot;
+   }
 };
 
 
@@ -73,12 +216,9 @@ ENG_API Eng::Managed::Managed(Managed &&other) : reserved(std::move(other.reserv
    ENG_LOG_DETAIL("[M]");
 
    // Update the reference:
-   for (auto it = allManaged.begin(); it != allManaged.end(); ++it)
-      if (it->get().reserved == other.reserved)
-      {
-         *it = *this; 
-         break;
-      }
+   std::lock_guard<std::recursive_mutex> lock(managedMutex);
+   if (reserved && reserved->slot != noSlot)
+      allManaged[reserved->slot] = this;
 }
 
 
@@ -90,13 +230,11 @@ ENG_API Eng::Managed::~Managed()
 {
    ENG_LOG_DETAIL("[-]");
 
-   if (!allManaged.empty())
-      for (auto it = allManaged.begin(); it != allManaged.end(); ++it)
-         if (it->get().reserved == this->reserved)
-         {  
-            allManaged.erase(it); // Already done in free
-            break;
-         }
+   if (reserved)
+   {
+      reserved->untrack(); // Already done in free
+      reserved->account(reserved->memoryType, 0);
+   }
 }
 
 
@@ -115,7 +253,7 @@ bool ENG_API Eng::Managed::init()
    }
 
    // Add to the list:
-   allManaged.push_back(*this);
+   reserved->track(this);
 
    // Done:
    reserved->initialized = true;
@@ -140,13 +278,8 @@ bool ENG_API Eng::Managed::free()
    }
    
    // Remove from list:
-   if (!allManaged.empty())
-      for (auto it = allManaged.begin(); it != allManaged.end(); ++it)
-         if (it->get().reserved == this->reserved)
-         {
-            allManaged.erase(it);
-            break;
-         }   
+   reserved->untrack();
+   reserved->account(reserved->memoryType, 0);
 
    // Done:
    reserved->initialized = false;
@@ -163,26 +296,23 @@ bool ENG_API Eng::Managed::forceRelease()
 {
    ENG_LOG_DEBUG("Forced release of managed objects...");
 
-   uint64_t total = 0, initialized = 0;
-   if (!allManaged.empty())
+   std::lock_guard<std::recursive_mutex> lock(managedMutex);
+   uint64_t total = allManaged.size(), initialized = 0;
+   while (!allManaged.empty())
    {
-      auto it = allManaged.begin();
-      while (it != allManaged.end()) 
-      {
-         total++;
-         bool isInitialized = it->get().isInitialized();
-         if (isInitialized)
-         {
-            initialized++;
-            auto _it = it;            
-            it++;            
-            _it->get().free();
-         }
-         else
-            ++it;         
-      }
+      Eng::Managed *m = allManaged.back();
+      const size_t nrOfManaged = allManaged.size();
+      m->free();
+      initialized++;
+
+      // Make sure to move on if a derived free() bailed out early:
+      if (allManaged.size() == nrOfManaged && allManaged.back() == m)
+         m->Eng::Managed::free();
    }
 
+   // The context is about to be released, so wait for the GPU and delete everything still queued:
+   flushReleased();
+
    // Done:
    ENG_LOG_DEBUG("%llu managed object(s) released out of %llu", initialized, total);
    return true;
@@ -196,16 +326,129 @@ bool ENG_API Eng::Managed::forceRelease()
  */
 void ENG_API Eng::Managed::dumpReport()
 {
+   std::lock_guard<std::recursive_mutex> lock(managedMutex);
    uint64_t total = 0, initialized = 0;
-   for (auto &m : allManaged)
+   for (Eng::Managed *m : allManaged)
    {
       total++;
-      if (m.get().isInitialized())
+      if (m->isInitialized())
          initialized++;           
    }
+   ENG_LOG_PLAIN("%llu managed object(s), %llu initialized, %llu name(s) pending deletion", total, initialized, static_cast<uint64_t>(pendingReleases.size())); 
+
+   // Device memory breakdown:
+   constexpr double mb = 1024.0 * 1024.0;
+   for (uint32_t c = 0; c < static_cast<uint32_t>(MemoryType::last); c++)
+   {
+      uint64_t nrOfObjects = 0;
+      for (Eng::Managed *m : allManaged)
+         if (m->reserved->memoryUsage && static_cast<uint32_t>(m->reserved->memoryType) == c)
+            nrOfObjects++;
+      ENG_LOG_PLAIN("   %-20s %10.2f MB (peak %10.2f MB) in %llu object(s)", getMemoryTypeName(static_cast<MemoryType>(c)), 
+                    allocatedMemory[c] / mb, peakMemory[c] / mb, nrOfObjects);
+   }
+   if (memoryBudget)
+      ENG_LOG_PLAIN("   %-20s %10.2f MB (peak %10.2f MB) of %.2f MB budget (%.1f%%)", "total", allocatedMemoryTotal / mb, peakMemoryTotal / mb,
+                    memoryBudget / mb, 100.0 * allocatedMemoryTotal / memoryBudget);
+   else
+      ENG_LOG_PLAIN("   %-20s %10.2f MB (peak %10.2f MB)", "total", allocatedMemoryTotal / mb, peakMemoryTotal / mb);
+
+   // Largest objects:
+   std::vector<Eng::Managed *> largest;
+   for (Eng::Managed *m : allManaged)
+      if (m->reserved->memoryUsage)
+         largest.push_back(m);
+   const size_t nrOfLargest = std::min<size_t>(largest.size(), 10);
+   std::partial_sort(largest.begin(), largest.begin() + nrOfLargest, largest.end(), 
+                     [](const Eng::Managed *a, const Eng::Managed *b) { return a->reserved->memoryUsage > b->reserved->memoryUsage; });
+   for (size_t c = 0; c < nrOfLargest; c++)
+   {
+      const Eng::Object *obj = dynamic_cast<const Eng::Object *>(largest[c]);
+      ENG_LOG_PLAIN("   #%-2zu %10.2f MB  %s (%s)", c + 1, largest[c]->reserved->memoryUsage / mb, 
+                    obj ? obj->getName().c_str() : "[unnamed]", getMemoryTypeName(largest[c]->reserved->memoryType));
+   }
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Queues an OpenGL name for deletion. The name is actually deleted by endFrame() once the fence placed after the
+ * current frame has signalled, so that releasing a resource still referenced by in-flight commands never stalls.
+ * @param type kind of resource
+ * @param oglId OpenGL name (0 is ignored)
+ */
+void ENG_API Eng::Managed::release(Resource type, uint32_t oglId)
+{
+   if (oglId == 0)
+      return;
+   std::lock_guard<std::recursive_mutex> lock(managedMutex);
+   pendingReleases.push_back({ type, oglId, releaseFrame });
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Ends a frame: fences the commands issued so far (if names were released during the frame) and deletes the names
+ * whose fences have already signalled. Never waits on the GPU.
+ * @return TF
+ */
+bool ENG_API Eng::Managed::endFrame()
+{
+   std::lock_guard<std::recursive_mutex> lock(managedMutex);
+
+   // Fence the frame, if something has been released during it:
+   if (!pendingReleases.empty() && pendingReleases.back().frame == releaseFrame)
+      releaseFences.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), releaseFrame });
+   releaseFrame++;
+
+   // Poll fences (oldest first) without blocking:
+   bool completed = false;
+   uint64_t completedFrame = 0;
+   while (!releaseFences.empty())
+   {
+      const GLenum status = glClientWaitSync(releaseFences.front().oglSync, 0, 0);
+      if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+         break;
+      completed = true;
+      completedFrame = releaseFences.front().frame;
+      glDeleteSync(releaseFences.front().oglSync);
+      releaseFences.pop_front();
+   }
+   if (!completed)
+      return true;
+
+   // Delete the names released up to the completed frame:
+   auto last = pendingReleases.begin();
+   while (last != pendingReleases.end() && last->frame <= completedFrame)
+      ++last;
+   deleteNames(pendingReleases.begin(), last);
+   pendingReleases.erase(pendingReleases.begin(), last);
 
    // Done:
-   ENG_LOG_PLAIN("%llu managed object(s), %llu initialized", total, initialized); 
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Waits for the GPU and deletes all the queued names (used before releasing the context).
+ * @return TF
+ */
+bool ENG_API Eng::Managed::flushReleased()
+{
+   std::lock_guard<std::recursive_mutex> lock(managedMutex);
+   if (pendingReleases.empty() && releaseFences.empty())
+      return true;
+
+   glFinish();
+   for (const ReleaseFence &fence : releaseFences)
+      glDeleteSync(fence.oglSync);
+   releaseFences.clear();
+   deleteNames(pendingReleases.begin(), pendingReleases.end());
+   pendingReleases.clear();
+
+   // Done:
+   return true;
 }
 
 
@@ -229,3 +472,138 @@ void ENG_API Eng::Managed::setInitialized(bool initializedFlag)
 {
    reserved->initialized = initializedFlag;
 }
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Sets the device memory used by the object, replacing the previous amount. Cleared automatically by free().
+ * @param type memory category
+ * @param nrOfBytes size in bytes
+ */
+void ENG_API Eng::Managed::setMemoryUsage(MemoryType type, uint64_t nrOfBytes)
+{
+   reserved->account(type, nrOfBytes);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the category of the device memory used by the object.
+ * @return memory category
+ */
+Eng::Managed::MemoryType ENG_API Eng::Managed::getMemoryType() const
+{
+   return reserved->memoryType;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the device memory used by the object.
+ * @return size in bytes
+ */
+uint64_t ENG_API Eng::Managed::getMemoryUsage() const
+{
+   return reserved->memoryUsage;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the device memory currently used by all the managed objects.
+ * @return size in bytes
+ */
+uint64_t ENG_API Eng::Managed::getAllocatedMemory()
+{
+   return allocatedMemoryTotal;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the device memory currently used by the managed objects of the given category.
+ * @param type memory category
+ * @return size in bytes
+ */
+uint64_t ENG_API Eng::Managed::getAllocatedMemory(MemoryType type)
+{
+   if (type >= MemoryType::last)
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return 0;
+   }
+   return allocatedMemory[static_cast<uint32_t>(type)];
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the high-water mark of the device memory used by all the managed objects.
+ * @return size in bytes
+ */
+uint64_t ENG_API Eng::Managed::getPeakMemory()
+{
+   return peakMemoryTotal;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the high-water mark of the device memory used by the managed objects of the given category.
+ * @param type memory category
+ * @return size in bytes
+ */
+uint64_t ENG_API Eng::Managed::getPeakMemory(MemoryType type)
+{
+   if (type >= MemoryType::last)
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return 0;
+   }
+   return peakMemory[static_cast<uint32_t>(type)];
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the device memory budget.
+ * @return size in bytes (0 when no budget is set)
+ */
+uint64_t ENG_API Eng::Managed::getMemoryBudget()
+{
+   return memoryBudget;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Sets the device memory budget. A warning is logged each time the allocated memory crosses it.
+ * @param nrOfBytes size in bytes (0 for no budget)
+ */
+void ENG_API Eng::Managed::setMemoryBudget(uint64_t nrOfBytes)
+{
+   memoryBudget = nrOfBytes;
+   memoryBudgetExceeded = false;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets a printable name for a memory category.
+ * @param type memory category
+ * @return name
+ */
+const char ENG_API *Eng::Managed::getMemoryTypeName(MemoryType type)
+{
+   switch (type)
+   {
+      case MemoryType::texture:              return "texture";
+      case MemoryType::vertexBuffer:         return "vertex buffer";
+      case MemoryType::indexBuffer:          return "index buffer";
+      case MemoryType::storageBuffer:        return "storage buffer";
+      case MemoryType::atomicCounterBuffer:  return "atomic counter buffer";
+      case MemoryType::pixelBuffer:          return "pixel buffer";
+      case MemoryType::renderbuffer:         return "renderbuffer";
+      default:                               return "unknown";
+   }
+}
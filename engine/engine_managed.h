@@ -17,6 +17,42 @@ class ENG_API Managed
 public: //
 //////////
 
+   /**
+    * @brief Kinds of OpenGL names whose deletion can be deferred.
+    */
+   enum class Resource : uint32_t
+   {
+      buffer,
+      texture,
+      vertexArray,
+      framebuffer,
+      renderbuffer,
+      program,
+      shader,
+
+      // Terminator:
+      last
+   };
+
+
+   /**
+    * @brief Categories of device memory accounted for.
+    */
+   enum class MemoryType : uint32_t
+   {
+      texture,
+      vertexBuffer,
+      indexBuffer,
+      storageBuffer,
+      atomicCounterBuffer,
+      pixelBuffer,
+      renderbuffer,
+
+      // Terminator:
+      last
+   };
+
+
     // Const/dest:
    Managed();
    Managed(Managed &&other);
@@ -32,9 +68,25 @@ public: //
    static bool forceRelease();
    static void dumpReport();
 
+   // Deferred deletion:
+   static void release(Resource type, uint32_t oglId);
+   static bool endFrame();
+   static bool flushReleased();
+
    // Get/set:
    bool isInitialized() const;   
 
+   // Memory accounting:
+   MemoryType getMemoryType() const;
+   uint64_t getMemoryUsage() const;
+   static uint64_t getAllocatedMemory();
+   static uint64_t getAllocatedMemory(MemoryType type);
+   static uint64_t getPeakMemory();
+   static uint64_t getPeakMemory(MemoryType type);
+   static uint64_t getMemoryBudget();
+   static void setMemoryBudget(uint64_t nrOfBytes);
+   static const char *getMemoryTypeName(MemoryType type);
+
 
 /////////////
 protected: //
@@ -42,6 +94,7 @@ protected: //
 
    // Get/set:
    void setInitialized(bool initializedFlag);
+   void setMemoryUsage(MemoryType type, uint64_t nrOfBytes);
 
 
 ///////////
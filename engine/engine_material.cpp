@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM scene
+
    // Main include:
    #include "engine.h"
 
@@ -23,6 +26,50 @@
    // Special values:
    Eng::Material Eng::Material::empty("[empty]");
 
+   // Cache:
+   std::reference_wrapper<const Eng::Material> Eng::Material::cache = Eng::Material::empty;
+   std::reference_wrapper<const Eng::Program> Eng::Material::cacheProgram = Eng::Program::empty;
+
+   // Pass changes:
+   std::atomic<uint64_t> Eng::Material::passVersion{ 0 };
+
+
+/**
+ * Loads an image file into a new texture stored in the container. Decoding runs on the calling thread, the upload
+ * is deferred to the context thread when needed.
+ * @param name image file name
+ * @return stored texture or Texture::empty on failure
+ */
+static const Eng::Texture &loadTexture(const std::string &name)
+{
+   Eng::Bitmap bitmap;
+   if (!bitmap.load(name))
+   {
+      ENG_LOG_ERROR("Unable to load image file '%s'", name.c_str());
+      return Eng::Texture::empty;
+   }
+
+   Eng::Container &container = Eng::Container::getInstance();
+   Eng::Bitmap &storedBitmap = container.store(bitmap);
+   Eng::Texture tex;
+   tex.setName(name);
+   Eng::Texture &storedTex = container.store(tex);
+   if (storedBitmap == Eng::Bitmap::empty || storedTex == Eng::Texture::empty)
+      return Eng::Texture::empty;
+
+   // Resolved by ID when the task runs, as the container may be reset in the meantime:
+   const uint32_t texId = storedTex.getId(), bitmapId = storedBitmap.getId();
+   Eng::Base::getInstance().enqueue([texId, bitmapId]()
+   {
+      Eng::Container &container = Eng::Container::getInstance();
+      Eng::Texture &tex = container.find<Eng::Texture>(texId);
+      const Eng::Bitmap &bitmap = container.find<Eng::Bitmap>(bitmapId);
+      if (tex != Eng::Texture::empty && bitmap != Eng::Bitmap::empty)
+         tex.load(bitmap);
+   });
+   return storedTex;
+}
+
 
 
 /////////////////////////
@@ -45,6 +92,14 @@ struct Eng::Material::Reserved
 
    std::reference_wrapper<const Eng::Texture> texture[Eng::Material::maxNrOfTextures];
 
+   // Layout of the PBR props in the OVO chunk:
+   static constexpr auto schema = Eng::Serializer::schema(&Reserved::emission, &Reserved::albedo, &Reserved::roughness,
+                                                          &Reserved::metalness, &Reserved::opacity);
+
+
+   // Allocated from a pool:
+   ENG_POOLED(Reserved)
+
 
    /**
     * Constructor.
@@ -204,6 +259,8 @@ float ENG_API Eng::Material::getMetalness() const
  */
 void ENG_API Eng::Material::setOpacity(float opacity)
 {
+   if ((opacity < 1.0f) != (reserved->opacity < 1.0f))
+      invalidatePasses();
    reserved->opacity = opacity;
    setDirty(true);
 }
@@ -278,15 +335,12 @@ const Eng::Texture ENG_API &Eng::Material::getTexture(Eng::Texture::Type type) c
 uint32_t ENG_API Eng::Material::loadChunk(Eng::Serializer &serial, void *data)
 {
    // Chunk header:
-   uint32_t chunkId;
-   serial.deserialize(&chunkId, sizeof(uint32_t));
-   if (chunkId != static_cast<uint32_t>(Ovo::ChunkId::material))
+   Ovo::ChunkHeader header;
+   if (!serial.read(header, Ovo::chunkHeaderSchema) || header.id != static_cast<uint32_t>(Ovo::ChunkId::material))
    {
       ENG_LOG_ERROR("Invalid chunk ID found");
       return 0;
    }
-   uint32_t chunkSize;
-   serial.deserialize(&chunkSize, sizeof(uint32_t));
 
    // Material properties:
    std::string name;
@@ -294,93 +348,58 @@ uint32_t ENG_API Eng::Material::loadChunk(Eng::Serializer &serial, void *data)
    this->setName(name);
 
    // PBR props:   
-   serial.deserialize(reserved->emission);
-   serial.deserialize(reserved->albedo);
-   serial.deserialize(reserved->roughness);
-   serial.deserialize(reserved->metalness);
-   serial.deserialize(reserved->opacity);
+   if (!serial.read(*reserved, Reserved::schema))
+      return 0;
    
 
-   // Textures:
-   Eng::Container &container = Eng::Container::getInstance();
-
-   // Albedo:
-   serial.deserialize(name); 
-   ENG_LOG_PLAIN("Texture (albedo): %s", name.c_str());
-   if (name != "[none]")
+   // Textures (height is ignored):
+   const Eng::Texture::Type types[] = { Eng::Texture::Type::albedo, Eng::Texture::Type::normal, Eng::Texture::Type::none,
+                                        Eng::Texture::Type::roughness, Eng::Texture::Type::metalness };
+   const char *labels[] = { "albedo", "normal", "height", "roughness", "metalness" };
+   for (uint32_t c = 0; c < 5; c++)
    {
-      Eng::Bitmap bitmap;
-      if (!bitmap.load(name))
-         ENG_LOG_ERROR("Unable to load image file '%s'", name.c_str());
-      else
-      {
-         Eng::Texture tex;
-         tex.load(bitmap);
-         container.add(tex);     
-         this->setTexture(container.getLastTexture(), Eng::Texture::Type::albedo);
-      }
+      serial.deserialize(name); 
+      ENG_LOG_PLAIN("Texture (%s): %s", labels[c], name.c_str());
+      if (name == "[none]" || types[c] == Eng::Texture::Type::none)
+         continue;
+
+      const Eng::Texture &tex = loadTexture(name);
+      if (tex != Eng::Texture::empty)
+         this->setTexture(tex, types[c]);
    }
 
-   // Normal:
-   serial.deserialize(name); 
-   ENG_LOG_PLAIN("Texture (normal): %s", name.c_str());
-   if (name != "[none]")
-   {
-      Eng::Bitmap bitmap;
-      if (!bitmap.load(name))
-         ENG_LOG_ERROR("Unable to load image file '%s'", name.c_str());
-      else
-      {
-         container.add(bitmap);
-         Eng::Texture tex;
-         tex.load(container.getLastBitmap());
-         container.add(tex);     
-         this->setTexture(container.getLastTexture(), Eng::Texture::Type::normal);
-      }
-   }
+   // Done:
+   return 1;
+}
 
-   // Height (ignored):
-   serial.deserialize(name); 
-   ENG_LOG_PLAIN("Texture (height): %s", name.c_str());
-   
-   // Roughness:
-   serial.deserialize(name); 
-   ENG_LOG_PLAIN("Texture (roughness): %s", name.c_str());
-   if (name != "[none]")
-   {
-      Eng::Bitmap bitmap;
-      if (!bitmap.load(name))
-         ENG_LOG_ERROR("Unable to load image file '%s'", name.c_str());
-      else
-      {
-         container.add(bitmap);
-         Eng::Texture tex;
-         tex.load(container.getLastBitmap());
-         container.add(tex);     
-         this->setTexture(container.getLastTexture(), Eng::Texture::Type::roughness);
-      }
-   }
 
-   // Metalness:
-   serial.deserialize(name); 
-   ENG_LOG_PLAIN("Texture (metalness): %s", name.c_str());
-   if (name != "[none]")
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves the specific information of a given object.
+ * @param serial serial data to append the chunk to
+ * @param data optional pointer
+ * @return TF
+ */
+bool ENG_API Eng::Material::saveChunk(Eng::Serializer &serial, void *data) const
+{
+   Eng::Serializer body;
+   if (!body.serialize(this->getName()) || !body.write(*reserved, Reserved::schema))
+      return false;
+
+   // Textures, in the same order as loadChunk() (height is never stored):
+   const Eng::Texture::Type types[] = { Eng::Texture::Type::albedo, Eng::Texture::Type::normal, Eng::Texture::Type::none,
+                                        Eng::Texture::Type::roughness, Eng::Texture::Type::metalness };
+   for (uint32_t c = 0; c < 5; c++)
    {
-      Eng::Bitmap bitmap;
-      if (!bitmap.load(name))
-         ENG_LOG_ERROR("Unable to load image file '%s'", name.c_str());
-      else
-      {
-         container.add(bitmap);
-         Eng::Texture tex;
-         tex.load(container.getLastBitmap());
-         container.add(tex);     
-         this->setTexture(container.getLastTexture(), Eng::Texture::Type::metalness);
-      }
-   }   
+      std::string name = "[none]";
+      if (types[c] != Eng::Texture::Type::none && getTexture(types[c]) != Eng::Texture::empty)
+         name = getTexture(types[c]).getName();
+      if (!body.serialize(name))
+         return false;
+   }
 
    // Done:
-   return 1;
+   return appendChunk(serial, Ovo::ChunkId::material, body);
 }
 
 
@@ -395,15 +414,21 @@ bool ENG_API Eng::Material::render(uint32_t value, void *data) const
 {	
    Eng::Program &prog = Eng::Program::getCached();
 
+   // Render only if necessary (same material already passed to the same program):
+   if (Eng::Material::cache.get() == *this && Eng::Material::cacheProgram.get() == prog)
+      return true;
+   Eng::Material::cache = *this;
+   Eng::Material::cacheProgram = prog;
+
    // Pass (some) params:
    prog.setVec3("mtlEmission", reserved->emission);
    prog.setVec3("mtlAlbedo", reserved->albedo);
    prog.setFloat("mtlRoughness", reserved->roughness);
    prog.setFloat("mtlOpacity", reserved->opacity);
     
-   // Pass textures:
+   // Pass textures (the default one until uploaded):
    for (uint32_t c = 0; c < Eng::Material::maxNrOfTextures; c++)
-      if (reserved->texture[c].get() != Eng::Texture::empty)
+      if (reserved->texture[c].get() != Eng::Texture::empty && reserved->texture[c].get().getOglHandle())
          reserved->texture[c].get().render(c);
       else
          Eng::Texture::getDefault().render(c);
@@ -411,3 +436,36 @@ bool ENG_API Eng::Material::render(uint32_t value, void *data) const
    // Done:
    return true;
 }
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Forgets the last material rendered, forcing the next render() call to pass its parameters again.
+ */
+void ENG_API Eng::Material::reset()
+{
+   Eng::Material::cache = Eng::Material::empty;
+   Eng::Material::cacheProgram = Eng::Program::empty;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets a counter incremented whenever a mesh may have moved between the solid and the transparent passes (opacity
+ * crossing 1, material of a mesh replaced). Lists compare it with the last value seen to re-sort their meshes.
+ * @return version
+ */
+uint64_t ENG_API Eng::Material::getPassVersion()
+{
+   return passVersion.load(std::memory_order_relaxed);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Signals that a mesh may have moved between the solid and the transparent passes.
+ */
+void ENG_API Eng::Material::invalidatePasses()
+{
+   passVersion.fetch_add(1, std::memory_order_relaxed);
+}
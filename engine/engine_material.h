@@ -39,14 +39,18 @@ public: //
    float getOpacity() const;
    float getRoughness() const;
    float getMetalness() const;   
+   static uint64_t getPassVersion();
+   static void invalidatePasses();
    bool setTexture(const Eng::Texture &tex, Eng::Texture::Type type = Eng::Texture::Type::albedo);
    const Eng::Texture &getTexture(Eng::Texture::Type type = Eng::Texture::Type::albedo) const;
 
    // Rendering methods:   
    bool render(uint32_t value = 0, void *data = nullptr) const;
+   static void reset();
 
    // Ovo:   
    uint32_t loadChunk(Eng::Serializer &serial, void *data = nullptr) override;
+   bool saveChunk(Eng::Serializer &serial, void *data = nullptr) const override;
 
 
 ///////////
@@ -59,6 +63,13 @@ private: //
 
    // Const/dest:
    Material(const std::string &name);
+
+   // Cache:
+   static std::reference_wrapper<const Eng::Material> cache;
+   static std::reference_wrapper<const Eng::Program> cacheProgram;
+
+   // Pass changes:
+   static std::atomic<uint64_t> passVersion;
 };
 
 
@@ -11,8 +11,12 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM scene
+
    // Main include:
    #include "engine.h"
+   #include "engine_ssbo.h"
 
    // GLM:
    #include <glm/gtc/packing.hpp>  
@@ -20,15 +24,337 @@
    // OGL:      
    #include <GL/glew.h>
    #include <GLFW/glfw3.h>
+
+   // C/C++:
+   #include <map>
+   #include <tuple>
+   #include <mutex>
+   #include <algorithm>
+   #include <limits>
    
 
 
+/////////////
+// SHADERS //
+/////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Meshlet culling compute shader. Each invocation tests one meshlet against the view frustum and its normal cone,
+ * and appends the indices of the surviving ones to the compacted index buffer, whose size is accumulated
+ * into the indirect draw command.
+ */
+static const std::string meshlet_cs = R"(
+
+layout(local_size_x = 64) in;
+
+struct Meshlet
+{
+   vec4 sphere;         // Center and radius (local coords)
+   vec4 cone;           // Axis (local coords) and cutoff
+   uint firstIndex;
+   uint nrOfIndices;
+   uint padding[2];
+};
+
+layout(std430, binding = 6) readonly buffer MeshletData { Meshlet meshlets[]; };
+layout(std430, binding = 7) readonly buffer IndexData { uint indices[]; };
+layout(std430, binding = 8) writeonly buffer CompactedData { uint compacted[]; };
+layout(std430, binding = 9) buffer CommandData
+{
+   uint count;
+   uint instanceCount;
+   uint firstIndex;
+   int baseVertex;
+   uint baseInstance;
+};
+
+// Uniforms:
+uniform mat4 modelviewMat;
+uniform mat4 projectionMat;
+uniform uint nrOfMeshlets;
+uniform float scale;
+uniform bool shortIndices;
+
+uint getIndex(uint i)
+{
+   if (shortIndices)
+      return (indices[i >> 1] >> ((i & 1u) * 16u)) & 0xffffu;
+   return indices[i];
+}
+
+void main()
+{
+   uint id = gl_GlobalInvocationID.x;
+   if (id >= nrOfMeshlets)
+      return;
+   Meshlet m = meshlets[id];
+
+   vec3 center = (modelviewMat * vec4(m.sphere.xyz, 1.0f)).xyz;
+   float radius = m.sphere.w * scale;
+
+   // Frustum (planes extracted from the projection matrix, view space):
+   mat4 p = transpose(projectionMat);
+   vec4 planes[6] = vec4[6](p[3] + p[0], p[3] - p[0], p[3] + p[1], p[3] - p[1], p[3] + p[2], p[3] - p[2]);
+   for (int c = 0; c < 6; c++)
+      if (dot(planes[c].xyz, center) + planes[c].w < -radius * length(planes[c].xyz))
+         return;
+
+   // Normal cone (the viewer is at the origin):
+   vec3 axis = normalize(mat3(modelviewMat) * m.cone.xyz);
+   if (dot(center, axis) >= m.cone.w * length(center) + radius)
+      return;
+
+   // Append:
+   uint dst = atomicAdd(count, m.nrOfIndices);
+   for (uint c = 0; c < m.nrOfIndices; c++)
+      compacted[dst + c] = getIndex(m.firstIndex + c);
+})";
+
+
+
 ////////////
 // STATIC //
 ////////////
 
    // Special values:
    Eng::Mesh Eng::Mesh::empty("[empty]");
+   constexpr uint32_t vertexCacheSize = 16;     ///< Post-transform cache size targeted by the index optimizer
+   static std::atomic<bool> keepGeometry{ false };    ///< Keep a CPU copy of the geometries (see Mesh::setKeepGeometry())
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Computes the average cache miss ratio (transformed vertices per triangle) of an index buffer, assuming a FIFO
+ * post-transform cache of vertexCacheSize entries.
+ * @param faces faces
+ * @param nrOfFaces number of faces
+ * @param nrOfVertices number of vertices
+ * @return ACMR (0.5 is ideal on regular meshes, 3 is worst)
+ */
+static float computeAcmr(const Eng::Ebo::FaceData *faces, uint32_t nrOfFaces, uint32_t nrOfVertices)
+{
+   if (nrOfFaces == 0)
+      return 0.0f;
+
+   std::vector<uint32_t> timeStamp(nrOfVertices, 0);
+   uint32_t time = vertexCacheSize + 1, misses = 0;
+   for (uint32_t f = 0; f < nrOfFaces; f++)
+      for (uint32_t v : { faces[f].a, faces[f].b, faces[f].c })
+         if (time - timeStamp[v] > vertexCacheSize)
+         {
+            timeStamp[v] = time++;
+            misses++;
+         }
+   return static_cast<float>(misses) / static_cast<float>(nrOfFaces);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Reorders the faces of a mesh for the post-transform vertex cache (Tipsify, Sander et al. 2007), then sorts the
+ * resulting clusters to reduce overdraw: clusters facing away from the mesh center are drawn first, as they are
+ * the most likely to occlude the others.
+ * @param faces faces to reorder (in place)
+ * @param nrOfFaces number of faces
+ * @param vertices vertices (used for the overdraw sort)
+ * @param nrOfVertices number of vertices
+ */
+static void optimizeFaces(Eng::Ebo::FaceData *faces, uint32_t nrOfFaces, const Eng::Vbo::VertexData *vertices, uint32_t nrOfVertices)
+{
+   if (nrOfFaces == 0)
+      return;
+
+   // Vertex-triangle adjacency:
+   std::vector<uint32_t> live(nrOfVertices, 0);
+   for (uint32_t f = 0; f < nrOfFaces; f++)
+      for (uint32_t v : { faces[f].a, faces[f].b, faces[f].c })
+         live[v]++;
+   std::vector<uint32_t> offset(nrOfVertices + 1, 0);
+   for (uint32_t v = 0; v < nrOfVertices; v++)
+      offset[v + 1] = offset[v] + live[v];
+   std::vector<uint32_t> adjacency(offset[nrOfVertices]);
+   std::vector<uint32_t> fill(offset.begin(), offset.end() - 1);
+   for (uint32_t f = 0; f < nrOfFaces; f++)
+      for (uint32_t v : { faces[f].a, faces[f].b, faces[f].c })
+         adjacency[fill[v]++] = f;
+
+   // Tipsify:
+   std::vector<uint32_t> timeStamp(nrOfVertices, 0);
+   std::vector<bool> emitted(nrOfFaces, false);
+   std::vector<uint32_t> deadEnd, candidates, order, clusters;
+   order.reserve(nrOfFaces);
+   uint32_t time = vertexCacheSize + 1, cursor = 1;
+   int64_t fanning = 0;
+   clusters.push_back(0);
+   while (fanning >= 0)
+   {
+      candidates.clear();
+      for (uint32_t c = offset[fanning]; c < offset[fanning + 1]; c++)
+      {
+         const uint32_t f = adjacency[c];
+         if (emitted[f])
+            continue;
+         for (uint32_t v : { faces[f].a, faces[f].b, faces[f].c })
+         {
+            deadEnd.push_back(v);
+            candidates.push_back(v);
+            live[v]--;
+            if (time - timeStamp[v] > vertexCacheSize)
+               timeStamp[v] = time++;
+         }
+         emitted[f] = true;
+         order.push_back(f);
+      }
+
+      // Next fanning vertex: the one in cache with the most pending triangles...
+      int64_t next = -1;
+      int64_t bestPriority = -1;
+      for (uint32_t v : candidates)
+         if (live[v] > 0)
+         {
+            int64_t priority = 0;
+            if (time - timeStamp[v] + 2 * live[v] <= vertexCacheSize)
+               priority = time - timeStamp[v];
+            if (priority > bestPriority)
+            {
+               bestPriority = priority;
+               next = v;
+            }
+         }
+
+      // ...otherwise, a dead-end (which starts a new cluster):
+      if (next == -1)
+      {
+         while (!deadEnd.empty() && next == -1)
+         {
+            const uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0)
+               next = v;
+         }
+         while (next == -1 && cursor < nrOfVertices)
+         {
+            if (live[cursor] > 0)
+               next = cursor;
+            cursor++;
+         }
+         if (next != -1 && order.size() > clusters.back())
+            clusters.push_back(static_cast<uint32_t>(order.size()));
+      }
+      fanning = next;
+   }
+   clusters.push_back(static_cast<uint32_t>(order.size()));
+
+   // Overdraw: sort clusters by how much they face away from the mesh centroid:
+   glm::vec3 meshCenter(0.0f);
+   for (uint32_t v = 0; v < nrOfVertices; v++)
+      meshCenter += vertices[v].vertex;
+   meshCenter /= static_cast<float>(std::max(nrOfVertices, 1u));
+
+   const uint32_t nrOfClusters = static_cast<uint32_t>(clusters.size()) - 1;
+   std::vector<float> sortKey(nrOfClusters);
+   std::vector<uint32_t> clusterOrder(nrOfClusters);
+   for (uint32_t c = 0; c < nrOfClusters; c++)
+   {
+      glm::vec3 center(0.0f), normal(0.0f);
+      float area = 0.0f;
+      for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+      {
+         const Eng::Ebo::FaceData &face = faces[order[t]];
+         const glm::vec3 &a = vertices[face.a].vertex, &b = vertices[face.b].vertex, &cc = vertices[face.c].vertex;
+         const glm::vec3 n = glm::cross(b - a, cc - a);
+         const float faceArea = glm::length(n);
+         center += (a + b + cc) * (faceArea / 3.0f);
+         normal += n;
+         area += faceArea;
+      }
+      if (area > 0.0f)
+         center /= area;
+      const float length = glm::length(normal);
+      sortKey[c] = length > 0.0f ? glm::dot(center - meshCenter, normal / length) : 0.0f;
+      clusterOrder[c] = c;
+   }
+   std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKey](uint32_t x, uint32_t y) { return sortKey[x] > sortKey[y]; });
+
+   // Apply:
+   std::vector<Eng::Ebo::FaceData> result;
+   result.reserve(nrOfFaces);
+   for (uint32_t c : clusterOrder)
+      for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+         result.push_back(faces[order[t]]);
+   std::copy(result.begin(), result.end(), faces);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Reorders the vertices of a mesh in the order they are first referenced by the faces, to improve the locality
+ * of vertex fetches. Unreferenced vertices are moved to the end.
+ * @param faces faces (indices are remapped in place)
+ * @param nrOfFaces number of faces
+ * @param vertices vertices to reorder (in place)
+ * @param nrOfVertices number of vertices
+ */
+static void optimizeVertexFetch(Eng::Ebo::FaceData *faces, uint32_t nrOfFaces, Eng::Vbo::VertexData *vertices, uint32_t nrOfVertices)
+{
+   constexpr uint32_t unused = 0xffffffff;
+   std::vector<uint32_t> remap(nrOfVertices, unused);
+   uint32_t next = 0;
+   for (uint32_t f = 0; f < nrOfFaces; f++)
+      for (uint32_t *v : { &faces[f].a, &faces[f].b, &faces[f].c })
+      {
+         if (remap[*v] == unused)
+            remap[*v] = next++;
+         *v = remap[*v];
+      }
+   for (uint32_t v = 0; v < nrOfVertices; v++)
+      if (remap[v] == unused)
+         remap[v] = next++;
+
+   std::vector<Eng::Vbo::VertexData> result(nrOfVertices);
+   for (uint32_t v = 0; v < nrOfVertices; v++)
+      result[remap[v]] = vertices[v];
+   std::copy(result.begin(), result.end(), vertices);
+}
+
+
+/**
+ * @brief Meshlet culling program of the current context (released by Mesh::freeSharedResources()).
+ */
+struct MeshletProgram
+{
+   std::unique_ptr<Eng::Shader> cs;
+   std::unique_ptr<Eng::Program> program;
+   bool failed = false;          ///< Build failed: not retried until the context is released
+};
+static MeshletProgram meshletProgram;
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the (lazily built) meshlet culling program.
+ * @return compute program, nullptr when not available
+ */
+static Eng::Program *getMeshletProgram()
+{
+   if (meshletProgram.program)
+      return meshletProgram.program.get();
+   if (meshletProgram.failed)
+      return nullptr;
+
+   auto cs = std::make_unique<Eng::Shader>();
+   auto program = std::make_unique<Eng::Program>();
+   if (cs->load(Eng::Shader::Type::compute, meshlet_cs) == false || program->build({ *cs }) == false)
+   {
+      ENG_LOG_ERROR("Unable to build meshlet culling program, meshlets are drawn without culling");
+      meshletProgram.failed = true;
+      return nullptr;
+   }
+   meshletProgram.cs = std::move(cs);
+   meshletProgram.program = std::move(program);
+   return meshletProgram.program.get();
+}
 
 
 
@@ -37,23 +363,523 @@
 /////////////////////////
 
 /**
- * @brief Mesh class reserved structure.
+ * @brief Geometry buffers, shared among all the meshes loaded with identical vertex and index payloads. All the
+ *        levels of detail are packed one after the other into the same VBO and EBO.
  */
-struct Eng::Mesh::Reserved
-{  
+struct MeshGeometry
+{
+   /**
+    * @brief Range of a level of detail within the buffers.
+    */
+   struct Lod
+   {
+      uint32_t firstFace;        ///< Position of the first face in the EBO
+      uint32_t nrOfFaces;        ///< Number of faces
+      uint32_t baseVertex;       ///< Position of the first vertex in the VBO
+   };
+
+   /**
+    * @brief Cluster of LOD 0 faces, culled as a whole (std430 layout).
+    */
+   struct Meshlet
+   {
+      glm::vec4 sphere;          ///< Bounding sphere center and radius (local coords)
+      glm::vec4 cone;            ///< Normal cone axis (local coords) and cutoff (1 when not cullable)
+      uint32_t firstIndex;       ///< Position of the first index in the EBO
+      uint32_t nrOfIndices;      ///< Number of indices
+      uint32_t padding[2];
+   };
+
+   /**
+    * @brief Indirect draw command, as expected by glDrawElementsIndirect.
+    */
+   struct DrawCommand
+   {
+      uint32_t count;
+      uint32_t instanceCount;
+      uint32_t firstIndex;
+      int32_t baseVertex;
+      uint32_t baseInstance;
+   };
+
    // Buffers:
    Eng::Vao vao;
    Eng::Vbo vbo;
    Eng::Ebo ebo;
+   std::vector<Lod> lods;
+
+   // Meshlets (high-poly geometries only):
+   uint32_t nrOfMeshlets;
+   Eng::Ssbo meshletBuffer;      ///< Meshlet descriptors
+   Eng::Ssbo compactedBuffer;    ///< Indices of the meshlets surviving culling
+   Eng::Ssbo commandBuffer;      ///< Indirect draw command filled by the culling pass
+
+   uint32_t id;                  ///< Unique ID (used for grouping draws)
+   std::atomic<bool> uploaded;   ///< False until the buffers are filled on the context thread
+
+   // CPU copy (only when keepGeometry is set):
+   std::vector<Eng::Vbo::VertexData> cpuVertices;
+   std::vector<Eng::Ebo::FaceData> cpuFaces;
+
+
+   /**
+    * Constructor
+    */
+   MeshGeometry() : nrOfMeshlets{ 0 }, uploaded{ false }
+   {
+      static std::atomic<uint32_t> counter{ 0 };
+      id = ++counter;
+   }
+
+
+   /**
+    * Splits faces into meshlets of at most Mesh::meshletMaxVertices vertices and Mesh::meshletMaxFaces faces, in
+    * their current order (already optimized for locality), and computes their bounding spheres and normal cones.
+    * @param faces faces
+    * @param nrOfFaces number of faces
+    * @param vertices vertices
+    * @param nrOfVertices number of vertices
+    * @return meshlets
+    */
+   static std::vector<Meshlet> buildMeshlets(const Eng::Ebo::FaceData *faces, uint32_t nrOfFaces,
+                                             const Eng::Vbo::VertexData *vertices, uint32_t nrOfVertices)
+   {
+      std::vector<Meshlet> meshlets;
+      std::vector<uint32_t> owner(nrOfVertices, 0xffffffff);
+      std::vector<uint32_t> used;
+
+      // Computes bounds of the faces in [first, last):
+      auto finalize = [&](uint32_t first, uint32_t last)
+      {
+         Meshlet meshlet = {};
+         glm::vec3 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+         for (uint32_t v : used)
+         {
+            min = glm::min(min, vertices[v].vertex);
+            max = glm::max(max, vertices[v].vertex);
+         }
+         const glm::vec3 center = (min + max) * 0.5f;
+         float radius = 0.0f;
+         for (uint32_t v : used)
+            radius = std::max(radius, glm::length(vertices[v].vertex - center));
+
+         glm::vec3 axis(0.0f);
+         std::vector<glm::vec3> normals;
+         for (uint32_t f = first; f < last; f++)
+         {
+            const glm::vec3 n = glm::cross(vertices[faces[f].b].vertex - vertices[faces[f].a].vertex,
+                                           vertices[faces[f].c].vertex - vertices[faces[f].a].vertex);
+            if (glm::length(n) > 0.0f)
+            {
+               normals.push_back(glm::normalize(n));
+               axis += normals.back();
+            }
+         }
+         float cutoff = 1.0f;
+         if (glm::length(axis) > 0.0f)
+         {
+            axis = glm::normalize(axis);
+            float minDot = 1.0f;
+            for (const glm::vec3 &n : normals)
+               minDot = std::min(minDot, glm::dot(axis, n));
+            if (minDot > 0.0f)
+               cutoff = sqrtf(1.0f - minDot * minDot);
+         }
+
+         meshlet.sphere = glm::vec4(center, radius);
+         meshlet.cone = glm::vec4(axis, cutoff);
+         meshlet.firstIndex = first * 3;
+         meshlet.nrOfIndices = (last - first) * 3;
+         meshlets.push_back(meshlet);
+         used.clear();
+      };
+
+      uint32_t first = 0;
+      for (uint32_t f = 0; f < nrOfFaces; f++)
+      {
+         uint32_t cur = static_cast<uint32_t>(meshlets.size());
+         const uint32_t a = faces[f].a, b = faces[f].b, c = faces[f].c;
+         const uint32_t newVertices = (owner[a] != cur) + (owner[b] != cur && b != a) + (owner[c] != cur && c != a && c != b);
+         if (f - first == Eng::Mesh::meshletMaxFaces || used.size() + newVertices > Eng::Mesh::meshletMaxVertices)
+         {
+            finalize(first, f);
+            first = f;
+            cur++;
+         }
+         for (uint32_t v : { a, b, c })
+            if (owner[v] != cur)
+            {
+               owner[v] = cur;
+               used.push_back(v);
+            }
+      }
+      if (first < nrOfFaces)
+         finalize(first, nrOfFaces);
+
+      return meshlets;
+   }
+
+
+   /**
+    * Culls the meshlets with a compute pre-pass and draws the surviving ones with an indirect call.
+    * @param cull meshlet culling program
+    * @param modelview modelview matrix
+    * @param projection projection matrix
+    */
+   void drawMeshlets(Eng::Program &cull, const glm::mat4 &modelview, const glm::mat4 &projection)
+   {
+      Eng::Program &program = Eng::Program::getCached();
+      
+      // Reset command:
+      const DrawCommand command = { 0, 1, 0, static_cast<int32_t>(lods[0].baseVertex), 0 };
+      commandBuffer.update(sizeof(DrawCommand), &command);
+
+      // Culling pass:
+      const glm::mat3 m(modelview);
+      cull.render();
+      cull.setMat4("modelviewMat", modelview);
+      cull.setMat4("projectionMat", projection);
+      cull.setUInt("nrOfMeshlets", nrOfMeshlets);
+      cull.setFloat("scale", std::max(glm::length(m[0]), std::max(glm::length(m[1]), glm::length(m[2]))));
+      cull.setInt("shortIndices", ebo.getIndexType() == Eng::Ebo::IndexType::uint16);
+      meshletBuffer.render(6);
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, ebo.getOglHandle());
+      compactedBuffer.render(8);
+      commandBuffer.render(9);
+      cull.compute((nrOfMeshlets + 63) / 64);
+      glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT);
+
+      // Draw (the compacted buffer temporarily replaces the EBO in the VAO):
+      program.render();
+      vao.render();
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, compactedBuffer.getOglHandle());
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer.getOglHandle());
+      glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+      ebo.render();
+   }
+
+
+   /**
+    * Draws a level of detail (clamped to the available ones).
+    * @param lod level of detail
+    * @param nrOfInstances number of instances (0 for a non-instanced draw)
+    * @param baseInstance position of the first instance
+    */
+   void draw(uint32_t lod, uint32_t nrOfInstances = 0, uint32_t baseInstance = 0) const
+   {
+      if (lods.empty() || !uploaded)
+         return;
+      const Lod &range = lods[std::min(lod, static_cast<uint32_t>(lods.size()) - 1)];
+      void *offset = reinterpret_cast<void *>(static_cast<uintptr_t>(range.firstFace) * ebo.getFaceSize());
+      const GLenum type = ebo.getOglIndexType();
+
+      vao.render();
+      if (nrOfInstances == 0)
+         glDrawElementsBaseVertex(GL_TRIANGLES, range.nrOfFaces * 3, type, offset, range.baseVertex);
+      else
+         glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, range.nrOfFaces * 3, type, offset,
+                                                       nrOfInstances, range.baseVertex, baseInstance);
+   }
+
+
+   /**
+    * Checks that every face only references vertices of its own LOD.
+    * @param vertices vertex data of all the LODs
+    * @param faces face data of all the LODs, with indices relative to each LOD's base vertex
+    * @param lods ranges of the LODs
+    * @return TF
+    */
+   static bool validate(const std::vector<Eng::Vbo::VertexData> &vertices, const std::vector<Eng::Ebo::FaceData> &faces,
+                        const std::vector<Lod> &lods)
+   {
+      for (uint32_t c = 0; c < lods.size(); c++)
+      {
+         const Lod &lod = lods[c];
+         const uint32_t lastVertex = c + 1 < lods.size() ? lods[c + 1].baseVertex : static_cast<uint32_t>(vertices.size());
+         const uint32_t lodNrOfVertices = lastVertex - lod.baseVertex;
+         for (uint32_t f = lod.firstFace; f < lod.firstFace + lod.nrOfFaces; f++)
+            if (faces[f].a >= lodNrOfVertices || faces[f].b >= lodNrOfVertices || faces[f].c >= lodNrOfVertices)
+               return false;
+      }
+      return true;
+   }
+
+
+   /**
+    * Optimizes each LOD for the vertex cache, overdraw and vertex fetch.
+    * @param vertices vertex data of all the LODs (reordered)
+    * @param faces face data of all the LODs, with indices relative to each LOD's base vertex (reordered)
+    * @param lods ranges of the LODs
+    */
+   static void optimize(std::vector<Eng::Vbo::VertexData> &vertices, std::vector<Eng::Ebo::FaceData> &faces,
+                        const std::vector<Lod> &lods)
+   {
+      for (uint32_t c = 0; c < lods.size(); c++)
+      {
+         const Lod &lod = lods[c];
+         const uint32_t lastVertex = c + 1 < lods.size() ? lods[c + 1].baseVertex : static_cast<uint32_t>(vertices.size());
+         Eng::Ebo::FaceData *lodFaces = faces.data() + lod.firstFace;
+         Eng::Vbo::VertexData *lodVertices = vertices.data() + lod.baseVertex;
+         const uint32_t lodNrOfVertices = lastVertex - lod.baseVertex;
+
+         const float acmr = computeAcmr(lodFaces, lod.nrOfFaces, lodNrOfVertices);
+         optimizeFaces(lodFaces, lod.nrOfFaces, lodVertices, lodNrOfVertices);
+         optimizeVertexFetch(lodFaces, lod.nrOfFaces, lodVertices, lodNrOfVertices);
+         ENG_LOG_DEBUG("LOD: %u, ACMR: %.3f -> %.3f", c + 1, acmr, computeAcmr(lodFaces, lod.nrOfFaces, lodNrOfVertices));
+      }
+   }
+
+
+   /**
+    * Fills the GPU buffers. Must run on the context thread.
+    * @param vertices vertex data of all the LODs
+    * @param faces face data of all the LODs
+    * @param meshlets meshlets of LOD 0 (empty for low-poly geometries)
+    */
+   void upload(const std::vector<Eng::Vbo::VertexData> &vertices, const std::vector<Eng::Ebo::FaceData> &faces,
+               const std::vector<Meshlet> &meshlets)
+   {
+      const uint32_t nrOfVertices = static_cast<uint32_t>(vertices.size());
+      vao.init();
+      vao.render();
+      vbo.create(nrOfVertices, vertices.data());
+
+      // Indices are relative to each LOD's base vertex, so 16 bits are enough when no LOD exceeds 65536 vertices:
+      uint32_t maxLodVertices = 0;
+      for (uint32_t c = 0; c < lods.size(); c++)
+         maxLodVertices = std::max(maxLodVertices, (c + 1 < lods.size() ? lods[c + 1].baseVertex : nrOfVertices) - lods[c].baseVertex);
+      ebo.create(static_cast<uint32_t>(faces.size()), faces.data(), maxLodVertices);
+
+      // Meshlets for high-poly geometries:
+      if (nrOfMeshlets)
+      {
+         meshletBuffer.create(meshlets.size() * sizeof(Meshlet), meshlets.data(), GL_STATIC_DRAW);
+         compactedBuffer.create(static_cast<uint64_t>(lods[0].nrOfFaces) * 3 * sizeof(uint32_t), nullptr, GL_DYNAMIC_COPY);
+         commandBuffer.create(sizeof(DrawCommand), nullptr, GL_DYNAMIC_DRAW);
+      }
+      uploaded = true;
+   }
+
+
+   /**
+    * Gets a shared geometry for the given payload, creating it if not already loaded. New geometries are optimized
+    * first (unless already optimized): being keyed on the incoming payload, the (costly) optimization runs only 
+    * once per distinct geometry. Payloads are identified by a 128-bit content hash (no copy of them is kept), and
+    * entries are dropped from the registry as soon as their geometry is released. Can be called from any thread: the CPU work runs on the caller, buffers are 
+    * filled on the context thread (deferred to the next frame when called from elsewhere).
+    * @param vertices vertex data of all the LODs (reordered when optimized, moved away unless keepPayload)
+    * @param faces face data of all the LODs, with indices relative to each LOD's base vertex (ditto)
+    * @param lods ranges of the LODs
+    * @param optimized true when the payload is already optimized (e.g., coming from a cache file)
+    * @param keepPayload true when the caller still needs vertices and faces on return
+    * @return shared geometry
+    */
+   static std::shared_ptr<MeshGeometry> get(std::vector<Eng::Vbo::VertexData> &vertices,
+                                            std::vector<Eng::Ebo::FaceData> &faces, const std::vector<Lod> &lods,
+                                            bool optimized = false, bool keepPayload = false)
+   {
+      const uint32_t nrOfVertices = static_cast<uint32_t>(vertices.size());
+      const uint32_t nrOfFaces = static_cast<uint32_t>(faces.size());
+
+      // 128-bit content hash (two independent 64-bit lanes, FNV-1a and multiply-rotate, over 8-byte words), combined
+      // with the sizes to make collisions practically impossible:
+      uint64_t hash = 14695981039346656037ull, hash2 = 0x9e3779b97f4a7c15ull;
+      auto hashWord = [&hash, &hash2](uint64_t word)
+      {
+         hash = (hash ^ word) * 1099511628211ull;
+         hash2 ^= word * 0xbf58476d1ce4e5b9ull;
+         hash2 = ((hash2 << 31) | (hash2 >> 33)) * 0x94d049bb133111ebull;
+      };
+      auto hashBytes = [&hashWord](const void *data, size_t size)
+      {
+         const uint8_t *bytes = static_cast<const uint8_t *>(data);
+         size_t c = 0;
+         for (; c + sizeof(uint64_t) <= size; c += sizeof(uint64_t))
+         {
+            uint64_t word;
+            memcpy(&word, bytes + c, sizeof(uint64_t));
+            hashWord(word);
+         }
+         uint64_t tail = 0;
+         if (c < size)
+            memcpy(&tail, bytes + c, size - c);
+         hashWord(tail ^ (static_cast<uint64_t>(size) << 56));
+      };
+      hashBytes(vertices.data(), nrOfVertices * sizeof(Eng::Vbo::VertexData));
+      hashBytes(faces.data(), nrOfFaces * sizeof(Eng::Ebo::FaceData));
+      hashBytes(lods.data(), lods.size() * sizeof(Lod));
+      const auto key = std::make_tuple(hash, hash2, nrOfVertices, nrOfFaces);
+
+      /**
+       * @brief Loaded geometries. Owned by the geometries too (through their deleter), so that it outlives them.
+       */
+      struct Registry
+      {
+         std::mutex mutex;
+         std::map<std::tuple<uint64_t, uint64_t, uint32_t, uint32_t>, std::weak_ptr<MeshGeometry>> entries;
+      };
+      static const std::shared_ptr<Registry> registry = std::make_shared<Registry>();
+      {
+         std::shared_ptr<MeshGeometry> geometry;
+         {
+            std::lock_guard<std::mutex> lock(registry->mutex);
+            auto it = registry->entries.find(key);
+            if (it != registry->entries.end())
+               geometry = it->second.lock();
+         }
+         if (geometry)
+            return geometry;
+      }
+
+      // Not loaded yet (optimized outside the lock, so that distinct geometries are processed in parallel):
+      std::shared_ptr<MeshGeometry> geometry(new MeshGeometry(), [registry = registry, key](MeshGeometry *geometry)
+      {
+         {
+            std::lock_guard<std::mutex> lock(registry->mutex);
+            auto it = registry->entries.find(key);
+            if (it != registry->entries.end() && it->second.expired())
+               registry->entries.erase(it);
+         }
+         delete geometry;
+      });
+      geometry->lods = lods;
+      if (!optimized)
+         optimize(vertices, faces, lods);
+      if (keepGeometry)
+      {
+         geometry->cpuVertices = vertices;
+         geometry->cpuFaces = faces;
+      }
+
+      // Meshlets for high-poly geometries:
+      std::vector<Meshlet> meshlets;
+      if (!lods.empty() && lods[0].nrOfFaces >= Eng::Mesh::meshletThreshold)
+      {
+         meshlets = buildMeshlets(faces.data() + lods[0].firstFace, lods[0].nrOfFaces,
+                                  vertices.data() + lods[0].baseVertex, 
+                                  (lods.size() > 1 ? lods[1].baseVertex : nrOfVertices) - lods[0].baseVertex);
+         geometry->nrOfMeshlets = static_cast<uint32_t>(meshlets.size());
+         ENG_LOG_DEBUG("Meshlets: %u", geometry->nrOfMeshlets);
+      }
+
+      // Another thread may have loaded the same payload in the meantime:
+      {
+         std::shared_ptr<MeshGeometry> other; // Released after the lock, as its deleter locks the registry
+         std::lock_guard<std::mutex> lock(registry->mutex);
+         auto &entry = registry->entries[key];
+         other = entry.lock();
+         if (other)
+            return other;
+         entry = geometry;
+      }
+
+      // GPU buffers:
+      Eng::Base &base = Eng::Base::getInstance();
+      if (base.isContextThread())
+         geometry->upload(vertices, faces, meshlets);
+      else if (keepPayload)
+         base.enqueue([geometry, vertices, faces, meshlets = std::move(meshlets)]() 
+         { 
+            geometry->upload(vertices, faces, meshlets); 
+         });
+      else
+         base.enqueue([geometry, vertices = std::move(vertices), faces = std::move(faces), meshlets = std::move(meshlets)]() 
+         { 
+            geometry->upload(vertices, faces, meshlets); 
+         });
+      return geometry;
+   }
+};
+
+
+/**
+ * @brief Mesh chunk data, following the node properties and the material name.
+ */
+struct MeshChunk
+{
+   float radius;                 ///< Bounding sphere radius
+   glm::vec3 bboxMin;            ///< Bounding box min corner
+   glm::vec3 bboxMax;            ///< Bounding box max corner
+   uint8_t hasPhysics;           ///< Physics section (unsupported) follows
+   uint32_t nrOfLods;            ///< Number of levels of detail
+};
+
+   // Packed layout:
+   static constexpr auto meshChunkSchema = Eng::Serializer::schema(&MeshChunk::radius, &MeshChunk::bboxMin, 
+      &MeshChunk::bboxMax, &MeshChunk::hasPhysics, &MeshChunk::nrOfLods);
+
+
+/**
+ * @brief Sizes preceding the vertex and face arrays (of each LOD or, in meshGpu chunks, of all of them).
+ */
+struct MeshSizes
+{
+   uint32_t nrOfVertices;
+   uint32_t nrOfFaces;
+};
+
+   // Packed layout:
+   static constexpr auto meshSizesSchema = Eng::Serializer::schema(&MeshSizes::nrOfVertices, &MeshSizes::nrOfFaces);
+
+
+/**
+ * Writes the mesh props and the packed LODs, as expected by meshGpu (or, when compressed, meshPacked) chunks.
+ * @param serial serial data to append to
+ * @param mesh mesh props (nrOfLods is overwritten)
+ * @param lods ranges of the LODs
+ * @param vertices vertex data of all the LODs
+ * @param faces face data of all the LODs
+ * @param compressed true to write vertices and faces as compressed streams
+ * @return TF
+ */
+static bool saveGeometry(Eng::Serializer &serial, MeshChunk mesh, const std::vector<MeshGeometry::Lod> &lods,
+                         const std::vector<Eng::Vbo::VertexData> &vertices, const std::vector<Eng::Ebo::FaceData> &faces,
+                         bool compressed = false)
+{
+   mesh.nrOfLods = static_cast<uint32_t>(lods.size());
+   const MeshSizes sizes = { static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(faces.size()) };
+   if (!serial.write(mesh, meshChunkSchema) || !serial.write(sizes, meshSizesSchema) ||
+       !serial.serialize(lods.data(), lods.size() * sizeof(MeshGeometry::Lod)))
+      return false;
+
+   // Indices change slowly once optimized for vertex fetch, so they are delta-coded:
+   if (compressed)
+      return serial.serializeStream(vertices.data(), sizes.nrOfVertices, sizeof(Eng::Vbo::VertexData)) &&
+             serial.serializeStream(faces.data(), sizes.nrOfFaces, sizeof(Eng::Ebo::FaceData), true);
+   return serial.serialize(vertices.data(), vertices.size() * sizeof(Eng::Vbo::VertexData)) &&
+          serial.serialize(faces.data(), faces.size() * sizeof(Eng::Ebo::FaceData));
+}
+
+
+/**
+ * @brief Mesh class reserved structure.
+ */
+struct Eng::Mesh::Reserved
+{  
+   // Buffers (nullptr until some geometry is loaded):
+   std::shared_ptr<MeshGeometry> geometry;
 
    // Material:
    std::reference_wrapper<const Eng::Material> material;
+
+   uint8_t subtype;              ///< OVO mesh subtype (kept for saving)
+
+   // Bounding volumes (local coords):
+   float radius;                 ///< Bounding sphere radius
+   glm::vec3 bboxMin;            ///< Bounding box min corner
+   glm::vec3 bboxMax;            ///< Bounding box max corner
    
 
+   // Allocated from a pool:
+   ENG_POOLED(Reserved)
+
+
    /**
     * Constructor
     */
-   Reserved() : material{ Eng::Material::empty }
+   Reserved() : material{ Eng::Material::empty }, subtype{ 0 },
+                radius{ 0.0f }, bboxMin{ 0.0f }, bboxMax{ 0.0f }
    {}
 };
 
@@ -112,6 +938,8 @@ ENG_API Eng::Mesh::~Mesh()
  */
 bool ENG_API Eng::Mesh::setMaterial(const Eng::Material &mat)
 {  
+   if ((mat.getOpacity() < 1.0f) != (reserved->material.get().getOpacity() < 1.0f))
+      Eng::Material::invalidatePasses();
    reserved->material = mat;      
 
    // Done:
@@ -132,106 +960,409 @@ const Eng::Material ENG_API &Eng::Mesh::getMaterial() const
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Loads the specific information of a given object. In its base class, this function loads the file version chunk.
+ * Gets the bounding sphere radius, as stored in the OVO file.
+ * @return radius in local coords
+ */
+float ENG_API Eng::Mesh::getRadius() const
+{
+   return reserved->radius;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the bounding box min corner.
+ * @return min corner in local coords
+ */
+const glm::vec3 ENG_API &Eng::Mesh::getBBoxMin() const
+{
+   return reserved->bboxMin;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the bounding box max corner.
+ * @return max corner in local coords
+ */
+const glm::vec3 ENG_API &Eng::Mesh::getBBoxMax() const
+{
+   return reserved->bboxMax;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets a bounding sphere enclosing the bounding box.
+ * @return sphere center (xyz) and radius (w) in local coords
+ */
+glm::vec4 ENG_API Eng::Mesh::getBoundingSphere() const
+{
+   const glm::vec3 center = (reserved->bboxMin + reserved->bboxMax) * 0.5f;
+   return glm::vec4(center, glm::length(reserved->bboxMax - reserved->bboxMin) * 0.5f);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the ID of the (possibly shared) geometry buffers. Meshes with the same geometry ID draw the same triangles.
+ * @return geometry ID (0 when the mesh has no geometry)
+ */
+uint32_t ENG_API Eng::Mesh::getGeometryId() const
+{
+   return reserved->geometry ? reserved->geometry->id : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of levels of detail available (LOD 0 is the most detailed).
+ * @return number of LODs
+ */
+uint32_t ENG_API Eng::Mesh::getNrOfLods() const
+{
+   return reserved->geometry ? static_cast<uint32_t>(reserved->geometry->lods.size()) : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of faces of a level of detail.
+ * @param lod level of detail
+ * @return number of faces (0 when the LOD is not available)
+ */
+uint32_t ENG_API Eng::Mesh::getNrOfFaces(uint32_t lod) const
+{
+   if (reserved->geometry == nullptr)
+      return 0;
+   const std::vector<MeshGeometry::Lod> &lods = reserved->geometry->lods;
+   return lod < lods.size() ? lods[lod].nrOfFaces : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of meshlets LOD 0 is split into (0 when the mesh is below meshletThreshold faces).
+ * @return number of meshlets
+ */
+uint32_t ENG_API Eng::Mesh::getNrOfMeshlets() const
+{
+   return reserved->geometry ? reserved->geometry->nrOfMeshlets : 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Keeps (or not) a CPU copy of the geometries loaded from now on. Required by saveChunk(), stripLods() and 
+ * updateBounds(), at the cost of doubling the memory footprint of the meshes: meant for offline tools.
+ * @param keep true to keep a CPU copy
+ */
+void ENG_API Eng::Mesh::setKeepGeometry(bool keep)
+{
+   keepGeometry = keep;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Tells whether a CPU copy of the geometries is kept.
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::getKeepGeometry()
+{
+   return keepGeometry;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Releases the GL resources shared by all the meshes (e.g., the meshlet culling program). Must be called on the
+ * context thread before the context is destroyed: they are created again, if needed, within the next context.
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::freeSharedResources()
+{
+   meshletProgram.program.reset();
+   meshletProgram.cs.reset();
+   meshletProgram.failed = false;
+
+   // Done:
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Loads the specific information of a given object. Both regular OVO mesh chunks and engine-native (meshGpu and
+ * meshPacked) chunks, storing the LODs already packed and optimized, are supported. Compressed streams are decoded
+ * in parallel through the job system.
  * @param serializer serial data
- * @param data optional pointer
+ * @param data optional pointer to a serializer where to append the mesh as a meshGpu chunk (for cache files)
  * @return TF
  */
 uint32_t ENG_API Eng::Mesh::loadChunk(Eng::Serializer &serial, void *data)
 {
    // Chunk header
-   uint32_t chunkId;
-   serial.deserialize(&chunkId, sizeof(uint32_t));
-   if (chunkId != static_cast<uint32_t>(Ovo::ChunkId::mesh))
+   Ovo::ChunkHeader header;
+   if (!serial.read(header, Ovo::chunkHeaderSchema) || 
+       (header.id != static_cast<uint32_t>(Ovo::ChunkId::mesh) && header.id != static_cast<uint32_t>(Ovo::ChunkId::meshGpu) &&
+        header.id != static_cast<uint32_t>(Ovo::ChunkId::meshPacked)))
    {
       ENG_LOG_ERROR("Invalid chunk ID found");
       return 0;
    }
-   uint32_t chunkSize;
-   serial.deserialize(&chunkSize, sizeof(uint32_t));
 
    // Node properties:       
-   std::string name;
-   serial.deserialize(name);   
-   this->setName(name);
-
-   glm::mat4 matrix;
-   serial.deserialize(matrix);
-   this->setMatrix(matrix);
-
-   uint32_t nrOfChildren;
-   serial.deserialize(nrOfChildren);
-
-   std::string target;
-   serial.deserialize(target);   
+   ChunkProps props;
+   if (!loadChunkProps(serial, props))
+      return 0;
+   this->setMatrix(props.matrix);
 
    // Data:
-   uint8_t subtype;
-   serial.deserialize(subtype);
+   serial.deserialize(reserved->subtype);
    
    std::string materialName;
    serial.deserialize(materialName);      
-   std::reference_wrapper<const Eng::Material> mat = Eng::Material::empty;
-   mat = dynamic_cast<Eng::Material &>(Eng::Container::getInstance().find(materialName));
-   this->setMaterial(mat);
+   this->setMaterial(Eng::Container::getInstance().find<Eng::Material>(materialName));
+
+   MeshChunk mesh;
+   if (!serial.read(mesh, meshChunkSchema))
+      return 0;
+   reserved->radius = mesh.radius;
+   reserved->bboxMin = mesh.bboxMin;
+   reserved->bboxMax = mesh.bboxMax;
+   if (mesh.hasPhysics)
+   {
+      ENG_LOG_ERROR("Physics section not supported");
+      return 0;
+   }
+
+   // All the LODs are appended into the same buffers:
+   std::vector<Eng::Vbo::VertexData> allVertices;
+   std::vector<Eng::Ebo::FaceData> allFaces;
+   std::vector<MeshGeometry::Lod> lods;
+   Eng::Serializer::Span<MeshGeometry::Lod> lodTable;
+   Eng::Serializer::Span<Eng::Vbo::VertexData> vertices;
+   Eng::Serializer::Span<Eng::Ebo::FaceData> faces;
+   const bool packed = header.id == static_cast<uint32_t>(Ovo::ChunkId::meshPacked);
+   bool optimized = packed || header.id == static_cast<uint32_t>(Ovo::ChunkId::meshGpu);
+   if (optimized)
+   {
+      // Already in upload layout (sizes checked against the chunk before allocating anything):
+      MeshSizes sizes;
+      if (!serial.read(sizes, meshSizesSchema) || !serial.read(lodTable, mesh.nrOfLods))
+         return 0;
+      const uint64_t nrOfBytes = static_cast<uint64_t>(sizes.nrOfVertices) * sizeof(Eng::Vbo::VertexData) + 
+                                 static_cast<uint64_t>(sizes.nrOfFaces) * sizeof(Eng::Ebo::FaceData);
+      if (nrOfBytes > serial.getNrOfRemainingBytes() * (packed ? Eng::Serializer::maxStreamRatio : 1))
+      {
+         ENG_LOG_ERROR("Invalid geometry size");
+         return 0;
+      }
+      lods.resize(mesh.nrOfLods);
+      lodTable.copyTo(lods.data());
+      uint32_t prevBaseVertex = 0;
+      for (const MeshGeometry::Lod &lod : lods)
+      {
+         if (static_cast<uint64_t>(lod.firstFace) + lod.nrOfFaces > sizes.nrOfFaces || 
+             lod.baseVertex < prevBaseVertex || lod.baseVertex > sizes.nrOfVertices)
+         {
+            ENG_LOG_ERROR("Invalid LOD table");
+            return 0;
+         }
+         prevBaseVertex = lod.baseVertex;
+      }
+      allVertices.resize(sizes.nrOfVertices);
+      allFaces.resize(sizes.nrOfFaces);
+      if (packed)
+      {
+         if (!serial.deserializeStream(allVertices.data(), sizes.nrOfVertices, sizeof(Eng::Vbo::VertexData)) ||
+             !serial.deserializeStream(allFaces.data(), sizes.nrOfFaces, sizeof(Eng::Ebo::FaceData), true))
+            return 0;
+      }
+      else
+      {
+         if (!serial.read(vertices, sizes.nrOfVertices) || !serial.read(faces, sizes.nrOfFaces))
+            return 0;
+         vertices.copyTo(allVertices.data());
+         faces.copyTo(allFaces.data());
+      }
+   }
+   else
+   {
+      // Every LOD starts with its sizes:
+      if (mesh.nrOfLods > serial.getNrOfRemainingBytes() / decltype(meshSizesSchema)::nrOfBytes)
+      {
+         ENG_LOG_ERROR("Invalid number of LODs");
+         return 0;
+      }
+      lods.resize(mesh.nrOfLods);
+   }
+   for (uint32_t curLod = 0; curLod < mesh.nrOfLods && !optimized; curLod++)
+   {
+      MeshSizes sizes;
+      if (!serial.read(sizes, meshSizesSchema) || 
+          !serial.read(vertices, sizes.nrOfVertices) || !serial.read(faces, sizes.nrOfFaces))
+         return 0;
+
+      ENG_LOG_PLAIN("LOD: %u, v: %u, f: %u", curLod + 1, sizes.nrOfVertices, sizes.nrOfFaces);
 
-   float radius;
-   serial.deserialize(radius);
+      lods[curLod] = { static_cast<uint32_t>(allFaces.size()), sizes.nrOfFaces, static_cast<uint32_t>(allVertices.size()) };
 
-   glm::vec3 bboxMin;
-   serial.deserialize(bboxMin);
+      allVertices.resize(allVertices.size() + sizes.nrOfVertices);
+      vertices.copyTo(allVertices.data() + lods[curLod].baseVertex);
 
-   glm::vec3 bboxMax;
-   serial.deserialize(bboxMax);
+      allFaces.resize(allFaces.size() + sizes.nrOfFaces);
+      faces.copyTo(allFaces.data() + lods[curLod].firstFace);
+   }   
 
-   uint8_t hasPhysics;
-   serial.deserialize(hasPhysics);
-   if (hasPhysics)
+   // Out-of-range indices would be read (and drawn) past the LOD:
+   if (!MeshGeometry::validate(allVertices, allFaces, lods))
    {
-      ENG_LOG_ERROR("Physics section not supported");
+      ENG_LOG_ERROR("Invalid face indices");
       return 0;
    }
 
-   uint32_t nrOfLods;
-   serial.deserialize(nrOfLods);
+   // Shared with other meshes when identical:
+   Eng::Serializer *cache = static_cast<Eng::Serializer *>(data);
+   if (cache && !optimized)
+   {
+      MeshGeometry::optimize(allVertices, allFaces, lods);
+      optimized = true;
+   }
+   if (mesh.nrOfLods)
+      reserved->geometry = MeshGeometry::get(allVertices, allFaces, lods, optimized, cache != nullptr);
 
-   for (uint32_t curLod = 0; curLod < nrOfLods; curLod++)
+   // Append to the cache:
+   if (cache)
    {
-      uint32_t nrOfVertices;
-      serial.deserialize(nrOfVertices);
+      Eng::Serializer chunk;
+      if (saveChunkProps(chunk, props) && chunk.serialize(reserved->subtype) && chunk.serialize(materialName) &&
+          saveGeometry(chunk, mesh, lods, allVertices, allFaces))
+         appendChunk(*cache, Ovo::ChunkId::meshGpu, chunk);
+   }
 
-      uint32_t nrOfFaces;
-      serial.deserialize(nrOfFaces);
+   // Done:      
+   return props.nrOfChildren;
+}
 
-      ENG_LOG_PLAIN("LOD: %u, v: %u, f: %u", curLod + 1, nrOfVertices, nrOfFaces);
 
-      std::vector<Eng::Vbo::VertexData> allVertices(nrOfVertices);
-      serial.deserialize(allVertices.data(), nrOfVertices * sizeof(Eng::Vbo::VertexData));
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves the specific information of a given object, as a meshGpu (or meshPacked) chunk. Requires the CPU copy of 
+ * the geometry.
+ * @param serial serial data to append the chunk to
+ * @param data optional pointer to a bool, true to compress the vertex and face streams
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::saveChunk(Eng::Serializer &serial, void *data) const
+{
+   static const std::vector<MeshGeometry::Lod> noLods;
+   static const std::vector<Eng::Vbo::VertexData> noVertices;
+   static const std::vector<Eng::Ebo::FaceData> noFaces;
+   const MeshGeometry *geometry = reserved->geometry.get();
+   if (geometry && !geometry->lods.empty() && geometry->cpuVertices.empty())
+   {
+      ENG_LOG_ERROR("Geometry of mesh '%s' not available (see setKeepGeometry())", this->getName().c_str());
+      return false;
+   }
 
-      std::vector<Eng::Ebo::FaceData> allFaces(nrOfFaces);
-      serial.deserialize(allFaces.data(), nrOfFaces * sizeof(Eng::Ebo::FaceData));
+   const Eng::Material &material = reserved->material;
+   const std::string materialName = material == Eng::Material::empty ? "[none]" : material.getName();
+   const MeshChunk mesh = { reserved->radius, reserved->bboxMin, reserved->bboxMax, 0, 0 };
+   const bool compressed = data && *static_cast<const bool *>(data);
 
-      // Store only first LOD for now:
-      if (curLod == 0)
-      {
-         reserved->vao.init();
-         reserved->vao.render();
-         
-         reserved->vbo.create(nrOfVertices, allVertices.data());
-         reserved->ebo.create(nrOfFaces, allFaces.data());
-      }
-   }   
+   Eng::Serializer body;
+   if (!saveChunkProps(body, getChunkProps()) || !body.serialize(reserved->subtype) || !body.serialize(materialName) ||
+       !saveGeometry(body, mesh, geometry ? geometry->lods : noLods, geometry ? geometry->cpuVertices : noVertices,
+                     geometry ? geometry->cpuFaces : noFaces, compressed))
+      return false;
 
-   // Done:      
-   return nrOfChildren;
+   // Done:
+   return appendChunk(serial, compressed ? Ovo::ChunkId::meshPacked : Ovo::ChunkId::meshGpu, body);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Drops the levels of detail beyond the given number. Requires the CPU copy of the geometry.
+ * @param nrOfLods number of LODs to keep (at least 1)
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::stripLods(uint32_t nrOfLods)
+{
+   if (reserved->geometry == nullptr)
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return false;
+   }
+   const MeshGeometry &geometry = *reserved->geometry;
+   if (nrOfLods == 0 || geometry.lods.empty() || geometry.cpuVertices.empty())
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return false;
+   }
+   if (nrOfLods >= geometry.lods.size())
+      return true;
+
+   // LODs are packed one after the other:
+   const MeshGeometry::Lod &first = geometry.lods[nrOfLods];
+   std::vector<MeshGeometry::Lod> lods(geometry.lods.begin(), geometry.lods.begin() + nrOfLods);
+   std::vector<Eng::Vbo::VertexData> vertices(geometry.cpuVertices.begin(), geometry.cpuVertices.begin() + first.baseVertex);
+   std::vector<Eng::Ebo::FaceData> faces(geometry.cpuFaces.begin(), geometry.cpuFaces.begin() + first.firstFace);
+   reserved->geometry = MeshGeometry::get(vertices, faces, lods, true);
+
+   // Done:
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Recomputes the bounding box and sphere from the vertices of LOD 0. Requires the CPU copy of the geometry.
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::updateBounds()
+{
+   if (reserved->geometry == nullptr)
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return false;
+   }
+   const MeshGeometry &geometry = *reserved->geometry;
+   if (geometry.lods.empty() || geometry.cpuVertices.empty())
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return false;
+   }
+
+   const uint32_t last = geometry.lods.size() > 1 ? geometry.lods[1].baseVertex : static_cast<uint32_t>(geometry.cpuVertices.size());
+   glm::vec3 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+   float radius = 0.0f;
+   for (uint32_t v = geometry.lods[0].baseVertex; v < last; v++)
+   {
+      const glm::vec3 &vertex = geometry.cpuVertices[v].vertex;
+      min = glm::min(min, vertex);
+      max = glm::max(max, vertex);
+      radius = std::max(radius, glm::length(vertex));
+   }
+   if (last == geometry.lods[0].baseVertex)
+      min = max = glm::vec3(0.0f);
+
+   reserved->bboxMin = min;
+   reserved->bboxMax = max;
+   reserved->radius = radius;
+
+   // Done:
+   return true;
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Rendering method. 
- * @param value generic value
- * @param data generic pointer to any kind of data
+ * @param value level of detail to draw
+ * @param data pointer to the modelview matrix
  * @return TF
  */
 bool ENG_API Eng::Mesh::render(uint32_t value, void *data) const
@@ -240,10 +1371,64 @@ bool ENG_API Eng::Mesh::render(uint32_t value, void *data) const
    program.setMat4("modelviewMat", *((glm::mat4 *) data));
    program.setMat3("normalMat", glm::inverseTranspose(glm::mat3(*((glm::mat4 *) data))));
 
+   program.setInt("instanced", 0);
+
+   reserved->material.get().render();
+   if (reserved->geometry)
+      reserved->geometry->draw(value);
+   
+   // Done:
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Instanced rendering method. Per-instance modelview matrices are read by the vertex shader from the instance buffer
+ * (already filled and bound by the caller), starting at the given base instance.
+ * @param nrOfInstances number of instances to draw
+ * @param baseInstance position of the first instance matrix in the instance buffer
+ * @param lod level of detail to draw
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::renderInstanced(uint32_t nrOfInstances, uint32_t baseInstance, uint32_t lod) const
+{	
+   Eng::Program &program = Eng::Program::getCached();
+   program.setInt("instanced", 1);
+
+   reserved->material.get().render();
+   if (reserved->geometry)
+      reserved->geometry->draw(lod, nrOfInstances, baseInstance);
+   
+   // Done:
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Rendering method with per-meshlet culling: a compute pre-pass discards the meshlets of LOD 0 that are outside
+ * the view frustum or entirely backfacing, then the others are drawn with a single indirect call. Falls back
+ * to the regular rendering method for meshes without meshlets.
+ * @param modelview modelview matrix
+ * @param projection projection matrix
+ * @return TF
+ */
+bool ENG_API Eng::Mesh::renderMeshlets(const glm::mat4 &modelview, const glm::mat4 &projection) const
+{	
+   if (reserved->geometry == nullptr || reserved->geometry->nrOfMeshlets == 0 || !reserved->geometry->uploaded)
+      return this->render(0, const_cast<glm::mat4 *>(&modelview));
+   Eng::Program *cull = getMeshletProgram();
+   if (cull == nullptr)
+      return this->render(0, const_cast<glm::mat4 *>(&modelview));
+
+   Eng::Program &program = Eng::Program::getCached();
+   program.setMat4("modelviewMat", modelview);
+   program.setMat3("normalMat", glm::inverseTranspose(glm::mat3(modelview)));
+   program.setInt("instanced", 0);
+
    reserved->material.get().render();
-  
-   reserved->vao.render();   
-   glDrawElements(GL_TRIANGLES, reserved->ebo.getNrOfFaces() * 3, GL_UNSIGNED_INT, nullptr);
+   reserved->geometry->drawMeshlets(*cull, modelview, projection);
    
    // Done:
    return true;
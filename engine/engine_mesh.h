@@ -19,6 +19,9 @@ public: //
 
    // Special values:
    static Mesh empty;   
+   constexpr static uint32_t meshletMaxVertices = 64;    ///< Max number of vertices per meshlet
+   constexpr static uint32_t meshletMaxFaces = 124;      ///< Max number of faces per meshlet
+   constexpr static uint32_t meshletThreshold = 16384;   ///< Min number of faces (LOD 0) for splitting a mesh into meshlets
 
    // Const/dest:
    Mesh();
@@ -32,12 +35,30 @@ public: //
    // Get/set:
    bool setMaterial(const Eng::Material &mat);
    const Eng::Material &getMaterial() const;
+   float getRadius() const;
+   const glm::vec3 &getBBoxMin() const;
+   const glm::vec3 &getBBoxMax() const;
+   glm::vec4 getBoundingSphere() const;
+   uint32_t getGeometryId() const;
+   uint32_t getNrOfLods() const;
+   uint32_t getNrOfFaces(uint32_t lod = 0) const;
+   uint32_t getNrOfMeshlets() const;
+   static void setKeepGeometry(bool keep);
+   static bool getKeepGeometry();
+   static bool freeSharedResources();
+
+   // Processing:
+   bool stripLods(uint32_t nrOfLods);
+   bool updateBounds();
    
    // Rendering methods:   
    bool render(uint32_t value = 0, void *data = nullptr) const;   
+   bool renderInstanced(uint32_t nrOfInstances, uint32_t baseInstance, uint32_t lod = 0) const;
+   bool renderMeshlets(const glm::mat4 &modelview, const glm::mat4 &projection) const;
 
    // Ovo:   
    uint32_t loadChunk(Eng::Serializer &serial, void *data = nullptr) override;
+   bool saveChunk(Eng::Serializer &serial, void *data = nullptr) const override;
 
 
 ///////////
@@ -11,11 +11,18 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM scene
+
    // Main include:
    #include "engine.h"
 
    // C/C++:
+   #include <algorithm>
    #include <map>
+   #include <vector>
+   #include <mutex>
+   #include <shared_mutex>
 
    
 
@@ -32,22 +39,232 @@
 // RESERVED STRUCTURES //
 /////////////////////////
 
+/**
+ * @brief Flat storage for the transforms of all the nodes. Arrays are indexed by slot and kept ordered so that 
+ *        parents always precede their children: world matrices are then updated with a single linear sweep.
+ *        Slot allocation, release and the sweep take the lock exclusively, per-slot accesses share it.
+ */
+struct NodeTransforms
+{
+   constexpr static uint32_t noParent = 0xffffffff;                     ///< Parent index of root nodes
+
+   std::vector<glm::mat4> local;                                        ///< Node matrices
+   std::vector<glm::mat4> world;                                        ///< World coordinate matrices
+   std::vector<uint32_t> parent;                                        ///< Parent slots
+   std::vector<uint8_t> dirty;                                          ///< True when the world matrix is outdated
+   std::vector<uint32_t *> slotRef;                                     ///< Back-reference to the owner's slot (nullptr when free)
+   uint32_t nrOfFree;                                                   ///< Number of released slots
+   std::atomic<bool> anyDirty;                                          ///< True when at least one slot is dirty
+   std::atomic<bool> sorted;                                            ///< False when a parent follows one of its children
+   std::atomic<uint64_t> version;                                       ///< Incremented each time world matrices change
+   mutable std::shared_mutex mutex;                                     ///< Guards the arrays above
+
+   std::vector<Eng::Node::Listener *> listeners;                        ///< Scene graph change listeners (kept here to share the lifetime)
+   std::mutex listenerMutex;                                            ///< Guards the listener list
+
+
+   /**
+    * Constructor. 
+    */
+   NodeTransforms() : nrOfFree{ 0 }, anyDirty{ false }, sorted{ true }, version{ 0 }
+   {}
+
+
+   /**
+    * Gets a snapshot of the listeners, so that they are notified (on the calling thread) without holding the lock.
+    * @return list of listeners
+    */
+   std::vector<Eng::Node::Listener *> getListeners()
+   {
+      std::lock_guard<std::mutex> lock(listenerMutex);
+      return listeners;
+   }
+
+
+   /**
+    * Gets the singleton (as a function-local static, since nodes are also created during static initialization).
+    * @return transform storage
+    */
+   static NodeTransforms &getInstance()
+   {
+      static NodeTransforms instance;
+      return instance;
+   }
+
+
+   /**
+    * Allocates a new (dirty) root slot.
+    * @param ref owner's slot variable, also written under the lock
+    */
+   void alloc(uint32_t *ref)
+   {
+      std::unique_lock<std::shared_mutex> lock(mutex);
+      const uint32_t slot = static_cast<uint32_t>(local.size());
+      local.push_back(glm::mat4(1.0f));
+      world.push_back(glm::mat4(1.0f));
+      parent.push_back(noParent);
+      dirty.push_back(1);
+      slotRef.push_back(ref);
+      *ref = slot;
+      anyDirty = true;
+   }
+
+
+   /**
+    * Releases a slot. Released slots are compacted away at the next reordering.
+    * @param slot slot to release
+    */
+   void release(uint32_t *ref)
+   {
+      std::unique_lock<std::shared_mutex> lock(mutex);
+      const uint32_t slot = *ref;
+      slotRef[slot] = nullptr;
+      parent[slot] = noParent;
+      nrOfFree++;
+      if (nrOfFree > 1024 && nrOfFree * 2 > local.size())
+         sorted = false;
+   }
+
+
+   /**
+    * Restores the parent-first ordering (and drops released slots) through a counting sort on the depth.
+    * Caller must hold the lock exclusively.
+    */
+   void reorder()
+   {
+      const uint32_t size = static_cast<uint32_t>(local.size());
+      constexpr uint32_t unknown = 0xffffffff;
+
+      // Depth of each slot:
+      std::vector<uint32_t> depth(size, unknown);
+      std::vector<uint32_t> stack;
+      uint32_t maxDepth = 0;
+      for (uint32_t c = 0; c < size; c++)
+      {
+         uint32_t cur = c;
+         while (depth[cur] == unknown && parent[cur] != noParent)
+         {
+            stack.push_back(cur);
+            cur = parent[cur];
+         }
+         if (depth[cur] == unknown)
+            depth[cur] = 0;
+         uint32_t d = depth[cur];
+         while (!stack.empty())
+         {
+            depth[stack.back()] = ++d;
+            stack.pop_back();
+         }
+         maxDepth = glm::max(maxDepth, depth[c]);
+      }
+
+      // Counting sort:
+      std::vector<uint32_t> offset(maxDepth + 2, 0);
+      for (uint32_t c = 0; c < size; c++)
+         if (slotRef[c])
+            offset[depth[c] + 1]++;
+      for (uint32_t c = 1; c < offset.size(); c++)
+         offset[c] += offset[c - 1];
+      std::vector<uint32_t> remap(size, noParent);
+      for (uint32_t c = 0; c < size; c++)
+         if (slotRef[c])
+            remap[c] = offset[depth[c]]++;
+
+      // Move data:
+      const uint32_t newSize = size - nrOfFree;
+      std::vector<glm::mat4> newLocal(newSize), newWorld(newSize);
+      std::vector<uint32_t> newParent(newSize);
+      std::vector<uint8_t> newDirty(newSize);
+      std::vector<uint32_t *> newSlotRef(newSize);
+      for (uint32_t c = 0; c < size; c++)
+      {
+         if (slotRef[c] == nullptr)
+            continue;
+         const uint32_t n = remap[c];
+         newLocal[n] = local[c];
+         newWorld[n] = world[c];
+         newParent[n] = (parent[c] == noParent) ? noParent : remap[parent[c]];
+         newDirty[n] = dirty[c];
+         newSlotRef[n] = slotRef[c];
+         *slotRef[c] = n;
+      }
+      local.swap(newLocal);
+      world.swap(newWorld);
+      parent.swap(newParent);
+      dirty.swap(newDirty);
+      slotRef.swap(newSlotRef);
+      nrOfFree = 0;
+      sorted = true;
+   }
+
+
+   /**
+    * Brings world matrices up to date with one linear sweep.
+    */
+   void update()
+   {
+      if (sorted && !anyDirty)
+         return;
+
+      std::unique_lock<std::shared_mutex> lock(mutex);
+      if (!sorted)
+         reorder();
+      if (!anyDirty)
+         return;
+
+      const uint32_t size = static_cast<uint32_t>(local.size());
+      for (uint32_t c = 0; c < size; c++)
+      {
+         const uint32_t p = parent[c];
+         if (p == noParent)
+         {
+            if (dirty[c])
+               world[c] = local[c];
+         }
+         else if (dirty[c] || dirty[p])
+         {
+            world[c] = world[p] * local[c];
+            dirty[c] = 1;
+         }
+      }
+      std::fill(dirty.begin(), dirty.end(), 0);
+      anyDirty = false;
+      version++;
+   }
+};
+
+
 /**
  * @brief Node reserved structure.
  */
 struct Eng::Node::Reserved
 {  
-   glm::mat4 matrix;                                                    ///< Node matrix
+   uint32_t slot;                                                       ///< Index in the flat transform storage
    std::reference_wrapper<Eng::Node> parent;                            ///< Parent node
    std::list<std::reference_wrapper<Eng::Node>> children;               ///< List of children nodes      
+   std::string target;                                                  ///< Target node name (from the OVO file)
+
+
+   // Allocated from a pool:
+   ENG_POOLED(Reserved)
 
 
    /**
     * Constructor. 
     */
-   Reserved() : matrix{ 1.0f },
-                parent{ Eng::Node::empty }
-   {}
+   Reserved() : parent{ Eng::Node::empty }, target{ "[none]" }
+   {
+      NodeTransforms::getInstance().alloc(&slot);
+   }
+
+
+   /**
+    * Destructor. 
+    */
+   ~Reserved()
+   {
+      NodeTransforms::getInstance().release(&slot);
+   }
 };
 
 
@@ -94,6 +311,11 @@ ENG_API Eng::Node::Node(Node &&other) : Eng::Object(std::move(other)), reserved(
 ENG_API Eng::Node::~Node()
 {	
    ENG_LOG_DETAIL("[-]");
+
+   // Notify listeners (unless moved):
+   if (reserved)
+      for (auto l : NodeTransforms::getInstance().getListeners())
+         l->nodeRemoved(reserved->parent, *this);
 }
 
 
@@ -104,29 +326,84 @@ ENG_API Eng::Node::~Node()
  */
 void ENG_API Eng::Node::setMatrix(const glm::mat4 &matrix) 
 {		
-   reserved->matrix = matrix;
+   NodeTransforms &transforms = NodeTransforms::getInstance();
+   std::shared_lock<std::shared_mutex> lock(transforms.mutex);
+   transforms.local[reserved->slot] = matrix;
+   transforms.dirty[reserved->slot] = 1;
+   transforms.anyDirty = true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Flags the cached world matrix of this node as outdated. Descendants are updated accordingly during the next sweep.
+ */
+void ENG_API Eng::Node::setWorldDirty()
+{
+   NodeTransforms &transforms = NodeTransforms::getInstance();
+   std::shared_lock<std::shared_mutex> lock(transforms.mutex);
+   transforms.dirty[reserved->slot] = 1;
+   transforms.anyDirty = true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Updates the world matrices of all the nodes with a single linear sweep over the flat transform storage. 
+ * Called implicitly by getWorldMatrix(), can be invoked once per frame before traversing the scene.
+ */
+void ENG_API Eng::Node::updateWorldMatrices()
+{
+   NodeTransforms::getInstance().update();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets a counter incremented every time world matrices are updated. Allows clients to skip work on static scenes.
+ * @return world matrices version
+ */
+uint64_t ENG_API Eng::Node::getWorldVersion()
+{
+   NodeTransforms &transforms = NodeTransforms::getInstance();
+   transforms.update();
+   return transforms.version;
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Gets the node matrix. 
+ * Gets the node matrix. Returned by value, as the transform storage can be reallocated by other threads as soon as
+ * the lock is released.
  * @return glm 4x4 matrix
  */
-const glm::mat4 ENG_API &Eng::Node::getMatrix() const
+glm::mat4 ENG_API Eng::Node::getMatrix() const
 {	
-   return reserved->matrix;
+   NodeTransforms &transforms = NodeTransforms::getInstance();
+   std::shared_lock<std::shared_mutex> lock(transforms.mutex);
+   return transforms.local[reserved->slot];
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Gets the world coordinate matrix of this node starting from the specified node (if empty, root node is used)
+ * Gets the world coordinate matrix of this node starting from the specified node (if empty, root node is used).
+ * Matrices relative to the root come from the flat transform storage and are only recomputed when outdated.
  * @param node starting node (root if empty)
  * @return world coordinate glm 4x4 matrix
  */
 glm::mat4 ENG_API Eng::Node::getWorldMatrix(Eng::Node &root) const
 {	
+   // Cached version:
+   if (root == Eng::Node::empty)
+   {
+      NodeTransforms &transforms = NodeTransforms::getInstance();
+      transforms.update();
+      std::shared_lock<std::shared_mutex> lock(transforms.mutex);
+      return transforms.world[reserved->slot];
+   }
+
+   // Relative to a specific node:
    auto current = std::reference_wrapper<Eng::Node>(const_cast<Eng::Node &>(* this));   
    glm::mat4 result = glm::mat4(1.0f);
 
@@ -161,6 +438,19 @@ Eng::Node ENG_API &Eng::Node::getParent() const
 void ENG_API Eng::Node::setParent(Eng::Node &parent)
 {	   
 	reserved->parent = parent;
+
+   // Update flat storage:
+   NodeTransforms &transforms = NodeTransforms::getInstance();
+   std::shared_lock<std::shared_mutex> lock(transforms.mutex);
+   const uint32_t slot = reserved->slot;
+   if (parent == Eng::Node::empty)
+      transforms.parent[slot] = NodeTransforms::noParent;
+   else
+   {
+      transforms.parent[slot] = parent.reserved->slot;
+      if (parent.reserved->slot > slot)
+         transforms.sorted = false;
+   }
 }
 
 
@@ -207,8 +497,13 @@ Eng::Node ENG_API &Eng::Node::removeChild(uint32_t id)
 	for (unsigned int c = 0; c < id; c++)	
 		i++;
 
+   // Notify listeners:
+   for (auto l : NodeTransforms::getInstance().getListeners())
+      l->nodeRemoved(*this, i->get());
+
    // Remove and update:
    i->get().setParent(Eng::Node::empty);
+   i->get().setWorldDirty();
    auto &x = i->get();
    reserved->children.erase(i);   
 	return x;		
@@ -240,6 +535,13 @@ bool ENG_API Eng::Node::addChild(Eng::Node &child)
 	// Add and update:
    reserved->children.push_back(child);	
    child.setParent(*this);
+   child.setWorldDirty();
+
+   // Notify listeners:
+   for (auto l : NodeTransforms::getInstance().getListeners())
+      l->nodeAdded(*this, child);
+
+   // Done:
    return true;
 }
 
@@ -266,6 +568,33 @@ const std::list<std::reference_wrapper<Eng::Node>> ENG_API &Eng::Node::getListOf
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////	 
+/** 
+ * Registers a listener notified whenever a node is attached to or detached from the scene graph. 
+ * @param listener listener to register
+ */	
+void ENG_API Eng::Node::addListener(Eng::Node::Listener &listener)
+{
+   NodeTransforms &transforms = NodeTransforms::getInstance();
+   std::lock_guard<std::mutex> lock(transforms.listenerMutex);
+   transforms.listeners.push_back(&listener);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////	 
+/** 
+ * Unregisters a listener. 
+ * @param listener listener to unregister
+ */	
+void ENG_API Eng::Node::removeListener(Eng::Node::Listener &listener)
+{
+   NodeTransforms &transforms = NodeTransforms::getInstance();
+   std::lock_guard<std::mutex> lock(transforms.listenerMutex);
+   auto &listeners = transforms.listeners;
+   listeners.erase(std::remove(listeners.begin(), listeners.end(), &listener), listeners.end());
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Loads the specific information of a given object. In its base class, this function loads the file version chunk.
@@ -276,32 +605,90 @@ const std::list<std::reference_wrapper<Eng::Node>> ENG_API &Eng::Node::getListOf
 uint32_t ENG_API Eng::Node::loadChunk(Eng::Serializer &serial, void *data)
 {
    // Chunk header
-   uint32_t chunkId;
-   serial.deserialize(&chunkId, sizeof(uint32_t));
-   if (chunkId != static_cast<uint32_t>(Ovo::ChunkId::node))
+   Ovo::ChunkHeader header;
+   if (!serial.read(header, Ovo::chunkHeaderSchema) || header.id != static_cast<uint32_t>(Ovo::ChunkId::node))
    {
       ENG_LOG_ERROR("Invalid chunk ID found");
       return 0;
    }
-   uint32_t chunkSize;
-   serial.deserialize(&chunkSize, sizeof(uint32_t));
 
    // Node properties:       
-   std::string name;
-   serial.deserialize(name);   
-   this->setName(name);
+   ChunkProps props;
+   if (!loadChunkProps(serial, props))
+      return 0;
+   this->setMatrix(props.matrix);
+
+   // Done:      
+   return props.nrOfChildren;
+}
 
-   glm::mat4 matrix;
-   serial.deserialize(matrix);
 
-   uint32_t nrOfChildren;
-   serial.deserialize(nrOfChildren);
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Loads the properties shared by all the node chunks (name, matrix, number of children and target), sets the name.
+ * @param serial serial data
+ * @param props loaded properties
+ * @return TF
+ */
+bool ENG_API Eng::Node::loadChunkProps(Eng::Serializer &serial, Eng::Node::ChunkProps &props)
+{
+   if (!serial.deserialize(props.name) || !serial.read(props, chunkPropsSchema) || !serial.deserialize(props.target))
+   {
+      ENG_LOG_ERROR("Corrupted node chunk");
+      return false;
+   }
+   this->setName(props.name);
+   reserved->target = props.target;
 
-   std::string target;
-   serial.deserialize(target);   
+   // Done:
+   return true;
+}
 
-   // Done:      
-   return nrOfChildren;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the current properties shared by all the node chunks.
+ * @return properties
+ */
+Eng::Node::ChunkProps ENG_API Eng::Node::getChunkProps() const
+{
+   ChunkProps props;
+   props.name = this->getName();
+   props.matrix = this->getMatrix();
+   props.nrOfChildren = this->getNrOfChildren();
+   props.target = reserved->target;
+   return props;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves the properties shared by all the node chunks, as read by loadChunkProps().
+ * @param serial serial data
+ * @param props properties to save
+ * @return TF
+ */
+bool ENG_API Eng::Node::saveChunkProps(Eng::Serializer &serial, const Eng::Node::ChunkProps &props)
+{
+   return serial.serialize(props.name) && serial.write(props, chunkPropsSchema) && serial.serialize(props.target);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves the specific information of a given object.
+ * @param serial serial data to append the chunk to
+ * @param data optional pointer
+ * @return TF
+ */
+bool ENG_API Eng::Node::saveChunk(Eng::Serializer &serial, void *data) const
+{
+   Eng::Serializer body;
+   if (!saveChunkProps(body, getChunkProps()))
+      return false;
+
+   // Done:
+   return appendChunk(serial, Ovo::ChunkId::node, body);
 }
 
 
@@ -9,7 +9,8 @@
 
 
 /**
- * @brief Class for modelling a generic node. 
+ * @brief Class for modelling a generic node. Transforms are stored in a flat, parent-first array shared by all the 
+ *        nodes, which only keep an index into it.
  */
 class ENG_API Node : public Eng::Object, public Eng::Ovo
 {
@@ -20,6 +21,19 @@ public: //
    // Special values:
    static Node empty;          
 
+
+   /**
+    * @brief Interface for receiving scene graph change notifications. Callbacks run on the thread that changed the graph.
+    */
+   class ENG_API Listener
+   {
+   public:
+      virtual ~Listener() = default;
+      virtual void nodeAdded(const Node &parent, const Node &child) = 0;
+      virtual void nodeRemoved(const Node &parent, const Node &child) = 0;
+   };
+
+
    // Const/dest:
 	Node();      
 	Node(Node &&other);
@@ -31,8 +45,10 @@ public: //
    
    // Positioning:
    void setMatrix(const glm::mat4 &matrix);
-   const glm::mat4 &getMatrix() const;
+   glm::mat4 getMatrix() const;
    glm::mat4 getWorldMatrix(Node &root = Node::empty) const;
+   static void updateWorldMatrices();
+   static uint64_t getWorldVersion();
 
    // Hierarchy:
    uint32_t getNrOfChildren() const;
@@ -42,8 +58,13 @@ public: //
    Node &removeChild(uint32_t id);   
    const std::list<std::reference_wrapper<Node>> &getListOfChildren() const;      
 
+   // Events:
+   static void addListener(Listener &listener);
+   static void removeListener(Listener &listener);
+
    // Ovo:   
    uint32_t loadChunk(Eng::Serializer &serial, void *data = nullptr) override;
+   bool saveChunk(Eng::Serializer &serial, void *data = nullptr) const override;
    
    // Debugging:
    std::string getTreeAsString() const;
@@ -62,6 +83,27 @@ protected: //
 
    // Hierarchy:
    void setParent(Node &parent);
+
+   // Positioning:
+   void setWorldDirty();
+
+
+   /**
+    * @brief Properties stored at the beginning of all the node chunks (nodes, meshes and lights).
+    */
+   struct ChunkProps
+   {
+      std::string name;
+      glm::mat4 matrix;
+      uint32_t nrOfChildren;
+      std::string target;
+   };
+   static constexpr auto chunkPropsSchema = Eng::Serializer::schema(&ChunkProps::matrix, &ChunkProps::nrOfChildren);
+
+   // Ovo:
+   bool loadChunkProps(Eng::Serializer &serial, ChunkProps &props);
+   ChunkProps getChunkProps() const;
+   static bool saveChunkProps(Eng::Serializer &serial, const ChunkProps &props);
 };
 
 
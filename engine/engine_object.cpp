@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM core
+
    // Main include:
    #include "engine.h"
 
@@ -23,9 +26,9 @@
    // Special values:
    Eng::Object Eng::Object::empty("[empty]");
 
-   // Parity check and counters:
-   static int32_t counter = 0;
-   static uint32_t idCounter = 0;
+   // Parity check and counters (atomic, as objects can be created by any thread):
+   static std::atomic<int32_t> counter{ 0 };
+   static std::atomic<uint32_t> idCounter{ 0 };
 
 
 
@@ -44,6 +47,10 @@ struct Eng::Object::Reserved
    bool dirty;                               ///< Object needs update  
 
 
+   // Allocated from a pool:
+   ENG_POOLED(Reserved)
+
+
    /**
     * Constructor.
     */
@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM loader
+
    // Main include:
    #include "engine.h"
    #include <functional>
@@ -19,6 +22,305 @@
    // GLM:
    #include <glm/gtc/packing.hpp>  
 
+   // C/C++:
+   #include <cstring>
+   #include <thread>
+   #include <mutex>
+   #include <condition_variable>
+   #include <deque>
+   #include <algorithm>
+   #include <filesystem>
+
+
+
+////////////
+// STATIC //
+////////////
+
+   // Special values:
+   constexpr uint64_t readBlockSize = 4 * 1024 * 1024;     ///< Block size used when hashing files
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Computes a 64-bit content hash (FNV-1a variant working on 8 bytes at a time, for speed on large files). Data can
+ * be hashed incrementally, in blocks whose size is a multiple of 8 bytes (but the last one).
+ * @param data data to hash
+ * @param size size in bytes
+ * @param hash hash of the previous blocks
+ * @return hash value
+ */
+static uint64_t hashContent(const void *data, uint64_t size, uint64_t hash = 14695981039346656037ull)
+{
+   const uint8_t *bytes = static_cast<const uint8_t *>(data);
+   uint64_t c = 0;
+   for (; c + sizeof(uint64_t) <= size; c += sizeof(uint64_t))
+   {
+      uint64_t word;
+      memcpy(&word, bytes + c, sizeof(uint64_t));
+      hash = (hash ^ word) * 1099511628211ull;
+   }
+   for (; c < size; c++)
+      hash = (hash ^ bytes[c]) * 1099511628211ull;
+   return hash;
+}
+
+
+
+/////////////////////////
+// RESERVED STRUCTURES //
+/////////////////////////
+
+/**
+ * @brief Incremental version of hashContent(), accepting blocks of any size.
+ */
+struct ContentHash
+{
+   uint64_t value;            ///< Hash of the bytes processed so far (pending ones excluded)
+   uint8_t pending[8];        ///< Bytes not yet forming a full 8-byte word
+   uint32_t nrOfPending;      ///< Number of pending bytes
+   uint64_t size;             ///< Total number of bytes added
+
+
+   /**
+    * Constructor.
+    */
+   ContentHash() : value{ 14695981039346656037ull }, nrOfPending{ 0 }, size{ 0 }
+   {}
+
+
+   /**
+    * Adds a block of data.
+    * @param data data to hash
+    * @param size size in bytes
+    */
+   void update(const void *data, uint64_t size)
+   {
+      const uint8_t *bytes = static_cast<const uint8_t *>(data);
+      this->size += size;
+      if (nrOfPending)
+      {
+         const uint32_t n = static_cast<uint32_t>(std::min<uint64_t>(sizeof(pending) - nrOfPending, size));
+         memcpy(pending + nrOfPending, bytes, n);
+         nrOfPending += n;
+         bytes += n;
+         size -= n;
+         if (nrOfPending < sizeof(pending))
+            return;
+         value = hashContent(pending, sizeof(pending), value);
+         nrOfPending = 0;
+      }
+      const uint64_t aligned = size & ~static_cast<uint64_t>(sizeof(pending) - 1);
+      value = hashContent(bytes, aligned, value);
+      nrOfPending = static_cast<uint32_t>(size - aligned);
+      memcpy(pending, bytes + aligned, nrOfPending);
+   }
+
+
+   /**
+    * Gets the hash of all the data added so far.
+    * @return hash value
+    */
+   uint64_t get() const
+   {
+      return hashContent(pending, nrOfPending, value);
+   }
+};
+
+
+/**
+ * @brief Header of the engine-native cache files, followed by the chunk stream (as in OVO files, with meshes stored
+ *        as meshGpu chunks). The source is assumed unchanged while its size and modification time match: its
+ *        content hash is only checked when the time differs (e.g., after a copy or a checkout).
+ */
+struct CacheHeader
+{
+   uint32_t magic;            ///< Always 'ENGC'
+   uint32_t version;          ///< Ovo::cacheVersion
+   uint64_t sourceHash;       ///< Content hash of the source OVO file
+   uint64_t sourceSize;       ///< Size of the source OVO file
+   int64_t sourceTime;        ///< Last modification time of the source OVO file (file clock ticks)
+
+
+   /**
+    * Constructor.
+    */
+   CacheHeader() : magic{ 0x43474e45 }, version{ Eng::Ovo::cacheVersion }, sourceHash{ 14695981039346656037ull }, 
+                   sourceSize{ 0 }, sourceTime{ 0 }
+   {}
+};
+
+
+/**
+ * @brief Sequential reader of the chunks of a file. A single reader thread, running for the whole lifetime of the
+ *        object, reads ahead a bounded number of chunks while the current one is parsed, overlapping I/O and parsing.
+ */
+struct ChunkReader
+{
+   constexpr static uint32_t maxNrOfQueued = 4; ///< Max number of chunks read ahead
+
+   FILE *dat;                                   ///< File (owned), positioned at the beginning of a chunk
+   uint64_t nrOfBytes;                          ///< Bytes left in the file (chunks claiming more are rejected)
+   std::thread thread;                          ///< Reader thread
+   std::mutex mutex;                            ///< Guards the queue and the flags below
+   std::condition_variable queueChanged;        ///< Signaled when a chunk is queued or dequeued
+   std::deque<std::vector<uint8_t>> queue;      ///< Chunks read ahead
+   bool done;                                   ///< True once the reader thread reached the end of the file
+   bool stop;                                   ///< True when the reader thread must quit
+   std::vector<uint8_t> buffer;                 ///< Next chunk, once dequeued
+   bool peeked;                                 ///< True when buffer holds the next chunk
+   bool corrupted;                              ///< True when the file ended in the middle of a chunk
+   bool hashing;                                ///< True when the content read is hashed
+   ContentHash hash;                            ///< Hash of the chunks read so far (when hashing)
+
+
+   /**
+    * Constructor.
+    * @param dat file to read (closed by the destructor)
+    * @param nrOfBytes bytes left in the file, from its current position
+    * @param hashing when true, the content is hashed while read (in background too)
+    */
+   ChunkReader(FILE *dat, uint64_t nrOfBytes, bool hashing = false) : dat{ dat }, nrOfBytes{ nrOfBytes }, done{ false }, 
+                                                                     stop{ false }, peeked{ false }, corrupted{ false }, 
+                                                                     hashing{ hashing }
+   {
+      thread = std::thread(&ChunkReader::run, this);
+   }
+
+
+   /**
+    * Destructor.
+    */
+   ~ChunkReader()
+   {
+      finish();
+      fclose(dat);
+   }
+
+
+   /**
+    * Stops the reader thread and waits for it, so that the hash can be read safely. Chunks not queued yet are not
+    * read (nor hashed) anymore.
+    */
+   void finish()
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         stop = true;
+      }
+      queueChanged.notify_all();
+      if (thread.joinable())
+         thread.join();
+   }
+
+
+   /**
+    * Reader thread: reads the chunks (header and body) one after the other, waiting while the queue is full.
+    */
+   void run()
+   {
+      while (true)
+      {
+         std::vector<uint8_t> chunk;
+         bool truncated = false;
+         uint32_t header[2];
+         if (fread(header, sizeof(uint32_t), 2, dat) == 2)
+         {
+            // The size is checked before allocating, as the file may be corrupted:
+            nrOfBytes -= std::min<uint64_t>(nrOfBytes, sizeof(header));
+            if (header[1] > nrOfBytes)
+               truncated = true;
+            else
+            {
+               chunk.resize(sizeof(header) + header[1]);
+               memcpy(chunk.data(), header, sizeof(header));
+               nrOfBytes -= header[1];
+               if (fread(chunk.data() + sizeof(header), sizeof(uint8_t), header[1], dat) != header[1])
+               {
+                  truncated = true;
+                  chunk.clear();
+               }
+               else if (hashing)
+                  hash.update(chunk.data(), chunk.size());
+            }
+         }
+
+         std::unique_lock<std::mutex> lock(mutex);
+         if (chunk.empty())
+         {
+            corrupted = truncated;
+            done = true;
+            queueChanged.notify_all();
+            return;
+         }
+         queueChanged.wait(lock, [this]() { return queue.size() < maxNrOfQueued || stop; });
+         if (stop)
+            return;
+         queue.push_back(std::move(chunk));
+         queueChanged.notify_all();
+      }
+   }
+
+
+   /**
+    * Gets the next chunk, without consuming it.
+    * @return chunk data (empty at the end of the file)
+    */
+   const std::vector<uint8_t> &peek()
+   {
+      if (!peeked)
+      {
+         std::unique_lock<std::mutex> lock(mutex);
+         queueChanged.wait(lock, [this]() { return !queue.empty() || done; });
+         if (!queue.empty())
+         {
+            buffer = std::move(queue.front());
+            queue.pop_front();
+            queueChanged.notify_all();
+         }
+         else
+            buffer.clear();
+         peeked = true;
+      }
+      return buffer;
+   }
+
+
+   /**
+    * Consumes the next chunk.
+    * @return chunk data (empty at the end of the file)
+    */
+   std::vector<uint8_t> get()
+   {
+      peek();
+      peeked = false;
+      std::vector<uint8_t> chunk = std::move(buffer);
+      buffer.clear();
+      return chunk;
+   }
+
+
+   /**
+    * Checks whether all the chunks have been read.
+    * @return TF
+    */
+   bool eof()
+   {
+      return peek().empty();
+   }
+
+
+   /**
+    * Checks whether the file ended in the middle of a chunk.
+    * @return TF
+    */
+   bool isCorrupted()
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      return corrupted;
+   }
+};
+
 
 
 ///////////////////////
@@ -34,19 +336,14 @@
  */
 uint32_t ENG_API Eng::Ovo::loadChunk(Eng::Serializer &serial, void *data)
 {
-   uint32_t chunkId;
-   serial.deserialize(chunkId);
-
-   if (chunkId != static_cast<uint32_t>(Ovo::ChunkId::version))
+   ChunkHeader header;
+   if (!serial.read(header, chunkHeaderSchema) || header.id != static_cast<uint32_t>(Ovo::ChunkId::version))
    {
       ENG_LOG_ERROR("Invalid chunk ID found");
       return 0;
    }   
-   
-   uint32_t chunkSize;
-   serial.deserialize(chunkSize);
 
-   uint32_t version;
+   uint32_t version = 0;
    serial.deserialize(version);
    if (version != Ovo::version)
    {
@@ -59,6 +356,116 @@ uint32_t ENG_API Eng::Ovo::loadChunk(Eng::Serializer &serial, void *data)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves the specific information of a given object. In its base class, this function saves the file version chunk.
+ * @param serial serial data to append the chunk to
+ * @param data optional pointer
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::saveChunk(Eng::Serializer &serial, void *data) const
+{
+   Eng::Serializer body;
+   body.serialize(Ovo::version);
+
+   // Done:
+   return appendChunk(serial, Ovo::ChunkId::version, body);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Appends a chunk (header followed by its body).
+ * @param serial serial data to append the chunk to
+ * @param id chunk ID
+ * @param body chunk body
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::appendChunk(Eng::Serializer &serial, Eng::Ovo::ChunkId id, const Eng::Serializer &body)
+{
+   const ChunkHeader header = { static_cast<uint32_t>(id), static_cast<uint32_t>(body.getNrOfBytes()) };
+   return serial.write(header, chunkHeaderSchema) && serial.serialize(body.getData(), body.getNrOfBytes());
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Saves a scene graph into an OVO file: the version chunk, the materials used by the meshes, then the nodes in 
+ * depth-first order. Meshes are written as meshGpu (or meshPacked) chunks, already packed and optimized, which
+ * requires their geometry to be kept on the CPU (see Mesh::setKeepGeometry()). Files can be read back with load().
+ * @param filename output file
+ * @param root root node of the scene graph
+ * @param compressed true to compress the vertex and face streams of the meshes (meshPacked chunks)
+ * @return TF
+ */
+bool ENG_API Eng::Ovo::save(const std::string &filename, const Eng::Node &root, bool compressed) const
+{
+   // Safety net:
+   if (filename.empty() || root == Eng::Node::empty)
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return false;
+   }
+
+   // Materials must precede the meshes referring to them:
+   std::vector<const Eng::Material *> materials;
+   std::function<void(const Eng::Node &)> collect = [&materials, &collect](const Eng::Node &node)
+   {
+      if (const auto mesh = dynamic_cast<const Eng::Mesh *>(&node))
+      {
+         const Eng::Material &material = mesh->getMaterial();
+         if (material != Eng::Material::empty && std::find(materials.begin(), materials.end(), &material) == materials.end())
+            materials.push_back(&material);
+      }
+      for (auto &child : node.getListOfChildren())
+         collect(child);
+   };
+   collect(root);
+
+   Eng::Serializer serial;
+   bool done = Ovo::saveChunk(serial);
+   for (auto material : materials)
+      done = done && material->saveChunk(serial);
+
+   // Hierarchy:
+   std::function<bool(const Eng::Node &)> saveNode = [&serial, &saveNode, &compressed](const Eng::Node &node)
+   {
+      if (!node.saveChunk(serial, &compressed))
+         return false;
+      for (auto &child : node.getListOfChildren())
+         if (!saveNode(child))
+            return false;
+      return true;
+   };
+   done = done && saveNode(root);
+   if (!done)
+   {
+      ENG_LOG_ERROR("Unable to serialize scene for file '%s'", filename.c_str());
+      return false;
+   }
+
+   // Write:
+   FILE *dat = fopen(filename.c_str(), "wb");
+   if (dat == nullptr)
+   {
+      ENG_LOG_ERROR("Unable to open file '%s'", filename.c_str());
+      return false;
+   }
+   const bool written = fwrite(serial.getData(), sizeof(uint8_t), serial.getNrOfBytes(), dat) == serial.getNrOfBytes();
+   fclose(dat);
+   if (!written)
+   {
+      ENG_LOG_ERROR("Unable to write file '%s'", filename.c_str());
+      return false;
+   }
+
+   // Done:
+   ENG_LOG_PLAIN("Saved %u materials into '%s' (%llu bytes)", static_cast<uint32_t>(materials.size()), filename.c_str(), 
+                 static_cast<unsigned long long>(serial.getNrOfBytes()));
+   return true;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Discards the current chunk and updates the serializer to the next chunk.
@@ -67,27 +474,27 @@ uint32_t ENG_API Eng::Ovo::loadChunk(Eng::Serializer &serial, void *data)
  */
 uint32_t ENG_API Eng::Ovo::ignoreChunk(Eng::Serializer &serial)
 {
-   uint32_t chunkId;
-   serial.deserialize(chunkId);
-   
-   uint32_t chunkSize;
-   serial.deserialize(chunkSize);   
-
-   std::vector<uint8_t> dummy(chunkSize);
-   serial.deserialize(dummy.data(), chunkSize);
+   ChunkHeader header;
+   if (!serial.read(header, chunkHeaderSchema) || serial.consume(header.size) == nullptr)
+      return 0;
 
    // Done:   
-   return chunkSize;
+   return header.size;
 }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- * Loads an OVO file.
+ * Loads an OVO file. The file is streamed one chunk at a time (the next chunk being read in background while the
+ * current one is parsed), so memory usage is bounded by the largest chunk rather than by the file size.
+ * When useCache is true, an engine-native cache file (same name, plus '.cache') is used instead when valid for 
+ * the current content of the OVO file, or (re)written otherwise. Meshes in the cache are already optimized and 
+ * packed in their upload layout, so loading them is little more than a memcpy.
  * @param filename 3D file 
+ * @param useCache when true, the cache file is used (and created if needed)
  * @return root node or Node::empty if error
  */
-Eng::Node ENG_API &Eng::Ovo::load(const std::string &filename)
+Eng::Node ENG_API &Eng::Ovo::load(const std::string &filename, bool useCache)
 {
    // Safety net:
    if (filename.empty())
@@ -97,8 +504,8 @@ Eng::Node ENG_API &Eng::Ovo::load(const std::string &filename)
    }
 
 
-   /////////////////////////////////////////
-   // STEP 1: load file into a memory buffer
+   //////////////////////////////////////////////////
+   // STEP 1: open file (or its cache, if up to date)
    bool error = false;
    FILE *dat = fopen(filename.c_str(), "rb");
    if (dat == nullptr)
@@ -107,37 +514,128 @@ Eng::Node ENG_API &Eng::Ovo::load(const std::string &filename)
       return Eng::Node::empty;
    }
 
-   // Get file length (max 2 GB):
-   uint64_t length;
-   fseek(dat, 0L, SEEK_END);
-      length = ftell(dat);
-   fseek(dat, 0L, SEEK_SET);
+   // Size and modification time of the source:
+   const std::string cacheName = filename + ".cache";
+   CacheHeader header;
+   if (useCache)
+   {
+      std::error_code ec;
+      header.sourceSize = std::filesystem::file_size(filename, ec);
+      if (!ec)
+         header.sourceTime = static_cast<int64_t>(std::filesystem::last_write_time(filename, ec).time_since_epoch().count());
+      if (ec)
+      {
+         ENG_LOG_WARN("Unable to access the attributes of file '%s', cache not used", filename.c_str());
+         useCache = false;
+      }
+   }
 
-   // Init mem and copy:
-   Eng::Serializer serial(nullptr, length);
-   if (fread(serial.getData(), sizeof(uint8_t), length, dat) != length)
+   // Use the cache file, when valid:
+   FILE *cacheDat = nullptr;
+   bool fromCache = false;
+   if (useCache)
    {
-      ENG_LOG_ERROR("File '%s' is corrupted", filename.c_str());
-      fclose(dat);
-      return Eng::Node::empty;
+      cacheDat = fopen(cacheName.c_str(), "rb");
+      CacheHeader cacheHeader;
+      bool valid = cacheDat && fread(&cacheHeader, sizeof(CacheHeader), 1, cacheDat) == 1 &&
+                   cacheHeader.magic == header.magic && cacheHeader.version == header.version &&
+                   cacheHeader.sourceSize == header.sourceSize;
+
+      // Same size, but touched since the cache was written: compare the content (streamed, no size limit):
+      if (valid && cacheHeader.sourceTime != header.sourceTime)
+      {
+         ContentHash hash;
+         std::vector<uint8_t> block(readBlockSize);
+         size_t read;
+         while ((read = fread(block.data(), sizeof(uint8_t), block.size(), dat)) > 0)
+            hash.update(block.data(), read);
+         rewind(dat);
+         valid = hash.get() == cacheHeader.sourceHash && hash.size == header.sourceSize;
+
+         // Still valid: refresh the time, so that the content is not hashed again next time:
+         if (valid)
+         {
+            cacheHeader.sourceTime = header.sourceTime;
+            FILE *cacheUpdate = fopen(cacheName.c_str(), "r+b");
+            if (cacheUpdate == nullptr || fwrite(&cacheHeader, sizeof(CacheHeader), 1, cacheUpdate) != 1)
+               ENG_LOG_WARN("Unable to update cache file '%s'", cacheName.c_str());
+            if (cacheUpdate)
+               fclose(cacheUpdate);
+         }
+      }
+
+      if (valid)
+      {
+         ENG_LOG_DEBUG("Using cache file '%s'", cacheName.c_str());
+         fclose(dat);
+         dat = cacheDat;
+         fromCache = true;
+         useCache = false;
+      }
+      else if (cacheDat)
+         fclose(cacheDat);
    }
-   fclose(dat);  
+
+   // Otherwise, (re)write it while parsing (into a temporary file, renamed once completed). The content hash of the
+   // source is computed while reading it, and written into the header at the end:
+   const std::string tmpCacheName = cacheName + ".tmp";
+   FILE *cacheOut = nullptr;
+   if (useCache)
+   {
+      cacheOut = fopen(tmpCacheName.c_str(), "wb");
+      if (cacheOut == nullptr || fwrite(&header, sizeof(CacheHeader), 1, cacheOut) != 1)
+         ENG_LOG_WARN("Unable to write cache file '%s'", tmpCacheName.c_str());
+   }
+   auto writeCache = [&cacheOut](const void *data, uint64_t size)
+   {
+      if (cacheOut && fwrite(data, sizeof(uint8_t), size, cacheOut) != size)
+      {
+         ENG_LOG_WARN("Unable to write cache file");
+         fclose(cacheOut);
+         cacheOut = nullptr;
+      }
+   };
+
+   // Bytes left to read (unbounded when unknown):
+   std::error_code ec;
+   const uint64_t fileSize = std::filesystem::file_size(fromCache ? cacheName : filename, ec);
+   const long position = ftell(dat);
+   const uint64_t nrOfBytes = ec || position < 0 ? UINT64_MAX : fileSize - std::min<uint64_t>(fileSize, position);
 
    // First chunk must be the format version:   
-   if (loadChunk(serial) == 0)
+   ChunkReader reader(dat, nrOfBytes, cacheOut != nullptr);
+   std::vector<uint8_t> chunk = reader.get();
+   Eng::Serializer versionChunk(chunk.data(), chunk.size());
+   if (chunk.empty() || loadChunk(versionChunk) == 0)
    {
       ENG_LOG_ERROR("Invalid format version or wrong file format for file '%s'", filename.c_str());
-      return Eng::Node::empty;
+      error = true;
    }
+   writeCache(chunk.data(), chunk.size());
    
 
    ///////////////////////////////
    // STEP 2: Materials and geoms:  
    Eng::Container &container = Eng::Container::getInstance();
    std::function<Eng::Node& (void)> parse;
-   parse = [&serial, &container, this, &parse, &error](void)->Eng::Node&
+   parse = [&reader, &container, this, &parse, &error, &writeCache, &cacheOut](void)->Eng::Node&
    {
-      switch (*(static_cast<uint8_t *>(serial.getDataAtCurPos())))
+      std::vector<uint8_t> chunk = reader.get();
+      if (chunk.empty())
+      {
+         ENG_LOG_ERROR("Unexpected end of file or corrupted chunk");
+         error = true;
+         return Eng::Node::empty;
+      }
+      Eng::Serializer serial(chunk.data(), chunk.size());
+
+      // Meshes are written by Mesh::loadChunk() in their own (meshGpu) format:
+      if (chunk[0] != static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh) && 
+          chunk[0] != static_cast<uint32_t>(Eng::Ovo::ChunkId::meshGpu) &&
+          chunk[0] != static_cast<uint32_t>(Eng::Ovo::ChunkId::meshPacked))
+         writeCache(chunk.data(), chunk.size());
+
+      switch (chunk[0])
       {
          ///////////////////////////////////////////////////////////
          case static_cast<uint32_t>(Eng::Ovo::ChunkId::material): //
@@ -158,9 +656,8 @@ Eng::Node ENG_API &Eng::Ovo::load(const std::string &filename)
 
             Eng::Node node;
             uint32_t nrOfChildren = node.loadChunk(serial);            
-            container.add(node);
-            std::reference_wrapper<Eng::Node> _node = container.getLastNode();
-            while (_node.get().getNrOfChildren() < nrOfChildren)
+            std::reference_wrapper<Eng::Node> _node = container.store(node);
+            while (_node.get().getNrOfChildren() < nrOfChildren && !error)
                _node.get().addChild(parse());              
             return _node;
          }
@@ -168,14 +665,17 @@ Eng::Node ENG_API &Eng::Ovo::load(const std::string &filename)
 
          ///////////////////////////////////////////////////////
          case static_cast<uint32_t>(Eng::Ovo::ChunkId::mesh): //
+         case static_cast<uint32_t>(Eng::Ovo::ChunkId::meshGpu):
+         case static_cast<uint32_t>(Eng::Ovo::ChunkId::meshPacked):
          {
             ENG_LOG_DEBUG("Processing mesh...");
 
             Eng::Mesh mesh;
-            uint32_t nrOfChildren = mesh.loadChunk(serial);            
-            container.add(mesh);
-            std::reference_wrapper<Eng::Mesh> _mesh = container.getLastMesh();
-            while (_mesh.get().getNrOfChildren() < nrOfChildren)
+            Eng::Serializer cache;
+            uint32_t nrOfChildren = mesh.loadChunk(serial, cacheOut ? &cache : nullptr);            
+            writeCache(cache.getData(), cache.getNrOfBytes());
+            std::reference_wrapper<Eng::Mesh> _mesh = container.store(mesh);
+            while (_mesh.get().getNrOfChildren() < nrOfChildren && !error)
                _mesh.get().addChild(parse());              
             return _mesh;
          }
@@ -188,9 +688,8 @@ Eng::Node ENG_API &Eng::Ovo::load(const std::string &filename)
 
             Eng::Light light;
             uint32_t nrOfChildren = light.loadChunk(serial);
-            container.add(light);
-            std::reference_wrapper<Eng::Light> _light = container.getLastLight();
-            while (_light.get().getNrOfChildren() < nrOfChildren)
+            std::reference_wrapper<Eng::Light> _light = container.store(light);
+            while (_light.get().getNrOfChildren() < nrOfChildren && !error)
                _light.get().addChild(parse());              
             return _light;
          }
@@ -206,9 +705,30 @@ Eng::Node ENG_API &Eng::Ovo::load(const std::string &filename)
 
    // Iterate:
    std::reference_wrapper<Eng::Node> root(Eng::Node::empty);
-   while (serial.getDataAtCurPos() && !error)
+   while (!error && !reader.eof())
       root = parse();
+   if (reader.isCorrupted())
+   {
+      ENG_LOG_ERROR("File '%s' is corrupted", filename.c_str());
+      error = true;
+   }
+
+   // Finalize the cache for the next time:
+   if (cacheOut)
+   {
+      // Discarded as well when the source changed while being read (or was not read up to the end):
+      reader.finish();
+      header.sourceHash = reader.hash.get();
+      const bool complete = reader.hash.size == header.sourceSize && fseek(cacheOut, 0, SEEK_SET) == 0 &&
+                            fwrite(&header, sizeof(CacheHeader), 1, cacheOut) == 1;
+      fclose(cacheOut);
+      remove(cacheName.c_str());
+      if (error || !complete || root.get() == Eng::Node::empty || rename(tmpCacheName.c_str(), cacheName.c_str()) != 0)
+         remove(tmpCacheName.c_str());
+      else
+         ENG_LOG_DEBUG("Cache file '%s' written", cacheName.c_str());
+   }
 
    // Done:   
-   return root;
+   return error ? Eng::Node::empty : root.get();
 }
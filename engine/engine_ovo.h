@@ -28,6 +28,7 @@ public: //
 
    // Consts:
    static constexpr uint32_t version = 8;       ///< OVO format revision (divide by 10)   
+   static constexpr uint32_t cacheVersion = 2;  ///< Engine-native cache format revision (bump when chunk layouts change)
 
 
    /**
@@ -41,14 +42,41 @@ public: //
       light    = 16,
       mesh     = 18,      
 
+      // Engine-native (cache and optimized files):
+      meshGpu     = 200,
+      meshPacked  = 201,   ///< meshGpu with compressed vertex and face streams
+
       // Terminator:
       last
    };
 
 
+   /**
+    * @brief Header preceding each chunk.
+    */
+   struct ChunkHeader
+   {
+      uint32_t id;         ///< Chunk ID
+      uint32_t size;       ///< Size of the chunk body
+   };
+   static constexpr auto chunkHeaderSchema = Eng::Serializer::schema(&ChunkHeader::id, &ChunkHeader::size);
+
+
    // Loading methods:
-   Eng::Node &load(const std::string &filename);
+   Eng::Node &load(const std::string &filename, bool useCache = true);
    virtual uint32_t loadChunk(Eng::Serializer &serial, void *data = nullptr);
    uint32_t ignoreChunk(Eng::Serializer &serial);
+
+   // Saving methods:
+   bool save(const std::string &filename, const Eng::Node &root, bool compressed = false) const;
+   virtual bool saveChunk(Eng::Serializer &serial, void *data = nullptr) const;
+
+
+/////////////
+protected: //
+/////////////
+
+   // Saving methods:
+   static bool appendChunk(Eng::Serializer &serial, ChunkId id, const Eng::Serializer &body);
 };
 
@@ -1,3 +1,6 @@
+// Logging subsystem:
+#define ENG_LOG_SUBSYSTEM pipeline
+
 // Main includes:
 #include "engine_pipeline_OIT.h"
 #include "engine.h"
@@ -39,12 +42,22 @@ out vec4 fragPosition;
 out vec3 normal;
 out vec2 uv;
 
+// Per-instance data (instanced draws only):
+uniform bool instanced;
+layout(std430, binding = 5) readonly buffer InstanceData
+{
+   mat4 instanceMat[];
+};
+
 void main()
 {
-   normal = normalMat * a_normal.xyz;
+   mat4 mvMat = instanced ? instanceMat[gl_BaseInstance + gl_InstanceID] : modelviewMat;
+   mat3 nMat = instanced ? inverse(transpose(mat3(mvMat))) : normalMat;
+
+   normal = nMat * a_normal.xyz;
    uv = a_uv;
 
-   fragPosition = modelviewMat * vec4(a_vertex, 1.0f);
+   fragPosition = mvMat * vec4(a_vertex, 1.0f);
    gl_Position = projectionMat * fragPosition;
 })";
 
@@ -114,6 +127,19 @@ struct NodeType {
 // Output to the framebuffer:
 out vec4 outFragment;
 
+/**
+ * Decodes a tangent-space normal map texel. Z is reconstructed from X and Y, so that two-channel (BC5) normal maps
+ * and regular RGB ones are handled alike.
+ * @param texel normal map texel
+ * @return unit normal (tangent space)
+ */
+vec3 decodeNormal(vec4 texel)
+{
+   vec2 xy = texel.xy * 2.0f - 1.0f;
+   return vec3(xy, sqrt(max(0.0f, 1.0f - dot(xy, xy))));
+}
+
+
 //////////
 // MAIN //
 //////////
@@ -122,7 +148,7 @@ vec3 compute_color()
 {
 // Texture lookup:
    vec4 albedo_texel = texture(texture0, uv);
-   vec4 normal_texel = texture(texture1, uv);
+   vec3 normal_texel = decodeNormal(texture(texture1, uv));
    vec4 roughness_texel = mtlRoughness * texture(texture2, uv);
    vec4 metalness_texel = mtlMetalness * texture(texture3, uv);
    float justUseIt = albedo_texel.r + normal_texel.r + roughness_texel.r + metalness_texel.r;
@@ -187,9 +213,18 @@ uniform mat3 normalMat;
 // Varying:
 out vec4 fragPosition;
 
+// Per-instance data (instanced draws only):
+uniform bool instanced;
+layout(std430, binding = 5) readonly buffer InstanceData
+{
+   mat4 instanceMat[];
+};
+
 void main()
 {
-   fragPosition = modelviewMat * vec4(a_vertex, 1.0f);
+   mat4 mvMat = instanced ? instanceMat[gl_BaseInstance + gl_InstanceID] : modelviewMat;
+
+   fragPosition = mvMat * vec4(a_vertex, 1.0f);
    gl_Position = projectionMat * fragPosition;
 }
 
@@ -0,0 +1,465 @@
+/**
+ * @file		engine_pipeline_hiz.cpp
+ * @brief	A pipeline for hierarchical-Z occlusion culling
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+
+
+
+//////////////
+// #INCLUDE //
+//////////////
+
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM pipeline
+
+   // Main include:
+   #include "engine.h"
+
+   // OGL:
+   #include <GL/glew.h>
+   #include <GLFW/glfw3.h>
+
+   // C/C++:
+   #include <cstring>
+
+
+
+/////////////
+// SHADERS //
+/////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Hi-Z reduction compute shader. Level 0 is copied from the depth map, each further level stores the max
+ * (i.e., farthest) depth of the texels it covers in the previous one.
+ */
+static const std::string pipeline_cs = R"(
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// Uniforms:
+uniform int level;
+layout(binding = 0) uniform sampler2D depthMap;
+layout(binding = 0, r32f) uniform writeonly image2D dst;
+layout(binding = 1, r32f) uniform readonly image2D src;
+
+void main()
+{
+   ivec2 pos = ivec2(gl_GlobalInvocationID.xy);
+   ivec2 dstSize = imageSize(dst);
+   if (pos.x >= dstSize.x || pos.y >= dstSize.y)
+      return;
+
+   // Level 0 is a plain copy:
+   if (level == 0)
+   {
+      imageStore(dst, pos, vec4(texelFetch(depthMap, pos, 0).r));
+      return;
+   }
+
+   // Odd sizes require an extra row/column to stay conservative:
+   ivec2 srcSize = imageSize(src);
+   ivec2 base = pos * 2;
+   ivec2 last = min(base + ivec2(1 + (srcSize.x & 1) * int(pos.x == dstSize.x - 1),
+                                 1 + (srcSize.y & 1) * int(pos.y == dstSize.y - 1)), srcSize - 1);
+   float maxDepth = 0.0f;
+   for (int y = base.y; y <= last.y; y++)
+      for (int x = base.x; x <= last.x; x++)
+         maxDepth = max(maxDepth, imageLoad(src, ivec2(x, y)).r);
+   imageStore(dst, pos, vec4(maxDepth));
+})";
+
+
+
+/////////////////////////
+// RESERVED STRUCTURES //
+/////////////////////////
+
+/**
+ * @brief PipelineHiZ reserved structure.
+ */
+struct Eng::PipelineHiZ::Reserved
+{
+   Eng::Shader cs;
+   Eng::Program program;
+   Eng::Texture depthMap;
+   Eng::Texture hizMap;
+   Eng::Fbo fbo;
+
+   // Asynchronous readback:
+   GLuint oglPbo;                   ///< Pixel pack buffer receiving the coarse level
+   GLsync oglFence;                 ///< Signaled when the readback is complete
+   uint32_t readbackLevel;          ///< Pyramid level read back
+   glm::u32vec2 readbackSize;       ///< Size of the level read back
+   std::vector<float> depths;       ///< Last completed readback
+   glm::mat4 pendingViewProj;       ///< View-projection matrix of the readback in flight
+   glm::mat4 viewProj;              ///< View-projection matrix of the last completed readback
+   bool available;                  ///< True once a readback has been completed
+
+   // Stats:
+   uint32_t nrOfCulled;             ///< Number of elements culled by the last cull()
+
+
+   /**
+    * Constructor.
+    */
+   Reserved() : oglPbo{ 0 }, oglFence{ nullptr }, readbackLevel{ 0 }, readbackSize{ 0, 0 },
+                pendingViewProj{ 1.0f }, viewProj{ 1.0f }, available{ false }, nrOfCulled{ 0 }
+   {}
+};
+
+
+
+///////////////////////////////
+// BODY OF CLASS PipelineHiZ //
+///////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Constructor.
+ */
+ENG_API Eng::PipelineHiZ::PipelineHiZ() : reserved(std::make_unique<Eng::PipelineHiZ::Reserved>())
+{
+   ENG_LOG_DETAIL("[+]");
+   this->setProgram(reserved->program);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Constructor with name.
+ * @param name node name
+ */
+ENG_API Eng::PipelineHiZ::PipelineHiZ(const std::string &name) : Eng::Pipeline(name), reserved(std::make_unique<Eng::PipelineHiZ::Reserved>())
+{
+   ENG_LOG_DETAIL("[+]");
+   this->setProgram(reserved->program);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Move constructor.
+ */
+ENG_API Eng::PipelineHiZ::PipelineHiZ(PipelineHiZ &&other) : Eng::Pipeline(std::move(other)), reserved(std::move(other.reserved))
+{
+   ENG_LOG_DETAIL("[M]");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Destructor.
+ */
+ENG_API Eng::PipelineHiZ::~PipelineHiZ()
+{
+   ENG_LOG_DETAIL("[-]");
+   if (this->isInitialized())
+      free();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the Hi-Z pyramid texture reference.
+ * @return Hi-Z texture reference
+ */
+const Eng::Texture ENG_API &Eng::PipelineHiZ::getHiZMap() const
+{
+   return reserved->hizMap;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of elements culled during the last call to cull().
+ * @return number of culled elements
+ */
+uint32_t ENG_API Eng::PipelineHiZ::getNrOfCulled() const
+{
+   return reserved->nrOfCulled;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Initializes this pipeline.
+ * @return TF
+ */
+bool ENG_API Eng::PipelineHiZ::init()
+{
+   // Already initialized?
+   if (this->Eng::Managed::init() == false)
+      return false;
+   if (!this->isDirty())
+      return false;
+
+   // Build:
+   reserved->cs.load(Eng::Shader::Type::compute, pipeline_cs);
+   if (reserved->program.build({ reserved->cs }) == false)
+   {
+      ENG_LOG_ERROR("Unable to build Hi-Z program");
+      return false;
+   }
+   this->setProgram(reserved->program);
+
+   // Depth map and pyramid:
+   const auto winSize = Eng::Base::getInstance().getWindowSize();
+   const uint32_t width = static_cast<uint32_t>(winSize.x);
+   const uint32_t height = static_cast<uint32_t>(winSize.y);
+   if (reserved->depthMap.create(width, height, Eng::Texture::Format::depth) == false)
+   {
+      ENG_LOG_ERROR("Unable to init depth map");
+      return false;
+   }
+   if (reserved->hizMap.create(width, height, Eng::Texture::Format::r32f, true) == false)
+   {
+      ENG_LOG_ERROR("Unable to init Hi-Z map");
+      return false;
+   }
+
+   // Depth FBO:
+   reserved->fbo.attachTexture(reserved->depthMap);
+   if (reserved->fbo.validate() == false)
+   {
+      ENG_LOG_ERROR("Unable to init depth FBO");
+      return false;
+   }
+
+   // Pick the first level small enough to be read back cheaply:
+   reserved->readbackLevel = 0;
+   while (reserved->readbackLevel < reserved->hizMap.getNrOfLevels() - 1 &&
+          glm::max(1u, width >> reserved->readbackLevel) > maxReadbackSize)
+      reserved->readbackLevel++;
+   reserved->readbackSize.x = glm::max(1u, width >> reserved->readbackLevel);
+   reserved->readbackSize.y = glm::max(1u, height >> reserved->readbackLevel);
+   reserved->depths.assign(reserved->readbackSize.x * reserved->readbackSize.y, 1.0f);
+   reserved->available = false;
+
+   // Readback buffer:
+   glCreateBuffers(1, &reserved->oglPbo);
+   glNamedBufferData(reserved->oglPbo, reserved->depths.size() * sizeof(float), nullptr, GL_STREAM_READ);
+   this->setMemoryUsage(MemoryType::pixelBuffer, reserved->depths.size() * sizeof(float));
+
+   // Done:
+   this->setDirty(false);
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Releases this pipeline.
+ * @return TF
+ */
+bool ENG_API Eng::PipelineHiZ::free()
+{
+   if (this->Eng::Managed::free() == false)
+      return false;
+
+   // Release readback resources:
+   if (reserved->oglFence)
+   {
+      glDeleteSync(reserved->oglFence);
+      reserved->oglFence = nullptr;
+   }
+   if (reserved->oglPbo)
+   {
+      Eng::Managed::release(Eng::Managed::Resource::buffer, reserved->oglPbo);
+      reserved->oglPbo = 0;
+   }
+   reserved->available = false;
+
+   // Done:
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Tests the meshes of the list against the last available Hi-Z readback and updates their visibility flag.
+ * The readback comes from a previous frame: never blocks, if no data is available yet everything stays visible.
+ * @param list list of renderables (typically just processed)
+ * @return TF
+ */
+bool ENG_API Eng::PipelineHiZ::cull(Eng::List &list)
+{
+   // Safety net:
+   if (list == Eng::List::empty)
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return false;
+   }
+   reserved->nrOfCulled = 0;
+
+   // Collect the readback in flight, if completed:
+   if (reserved->oglFence)
+   {
+      const GLenum status = glClientWaitSync(reserved->oglFence, 0, 0);
+      if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+      {
+         glDeleteSync(reserved->oglFence);
+         reserved->oglFence = nullptr;
+         const void *data = glMapNamedBufferRange(reserved->oglPbo, 0, reserved->depths.size() * sizeof(float), GL_MAP_READ_BIT);
+         if (data)
+         {
+            memcpy(reserved->depths.data(), data, reserved->depths.size() * sizeof(float));
+            glUnmapNamedBuffer(reserved->oglPbo);
+            reserved->viewProj = reserved->pendingViewProj;
+            reserved->available = true;
+         }
+      }
+   }
+   if (reserved->available == false)
+      return true;
+
+   const glm::ivec2 size = reserved->readbackSize;
+   const uint32_t nrOfElems = list.getNrOfRenderableElems();
+   for (uint32_t c = list.getNrOfLights(); c < nrOfElems; c++)
+   {
+      const Eng::List::RenderableElem &re = list.getRenderableElem(c);
+      list.setVisible(c, true);
+      const Eng::Mesh *mesh = dynamic_cast<const Eng::Mesh *>(&re.reference.get());
+      if (mesh == nullptr || mesh->getRadius() == 0.0f)
+         continue;
+
+      // World-space bounding sphere:
+      const glm::vec4 sphere = mesh->getBoundingSphere();
+      const glm::vec3 center = glm::vec3(re.matrix * glm::vec4(glm::vec3(sphere), 1.0f));
+      const float scale = glm::max(glm::length(glm::vec3(re.matrix[0])),
+                          glm::max(glm::length(glm::vec3(re.matrix[1])), glm::length(glm::vec3(re.matrix[2]))));
+      const float radius = sphere.w * scale;
+
+      // Project the corners of its enclosing box:
+      bool visible = false;
+      glm::vec2 minUv(1.0f), maxUv(0.0f);
+      float minDepth = 1.0f;
+      for (uint32_t d = 0; d < 8; d++)
+      {
+         const glm::vec3 corner = center + radius * glm::vec3((d & 1) ? 1.0f : -1.0f, (d & 2) ? 1.0f : -1.0f, (d & 4) ? 1.0f : -1.0f);
+         const glm::vec4 clip = reserved->viewProj * glm::vec4(corner, 1.0f);
+         if (clip.w <= 0.0f) // Crossing the near plane
+         {
+            visible = true;
+            break;
+         }
+         const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+         minUv = glm::min(minUv, glm::vec2(ndc) * 0.5f + 0.5f);
+         maxUv = glm::max(maxUv, glm::vec2(ndc) * 0.5f + 0.5f);
+         minDepth = glm::min(minDepth, ndc.z * 0.5f + 0.5f);
+      }
+      if (visible || minUv.x < 0.0f || minUv.y < 0.0f || maxUv.x > 1.0f || maxUv.y > 1.0f)
+         continue;
+
+      // Compare against the farthest occluder depth in the covered area:
+      const glm::ivec2 minTexel = glm::clamp(glm::ivec2(minUv * glm::vec2(size)), glm::ivec2(0), size - 1);
+      const glm::ivec2 maxTexel = glm::clamp(glm::ivec2(maxUv * glm::vec2(size)), glm::ivec2(0), size - 1);
+      for (int y = minTexel.y; y <= maxTexel.y && !visible; y++)
+         for (int x = minTexel.x; x <= maxTexel.x; x++)
+            if (minDepth <= reserved->depths[y * size.x + x])
+            {
+               visible = true;
+               break;
+            }
+
+      if (!visible)
+      {
+         list.setVisible(c, false);
+         reserved->nrOfCulled++;
+      }
+   }
+
+   // Done:
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Main rendering method for the pipeline: builds the Hi-Z pyramid from the depth buffer of the current frame and
+ * starts its asynchronous readback. To be called once the opaque geometry has been rendered.
+ * @param camera camera matrix
+ * @param proj projection matrix
+ * @param list list of renderables
+ * @return TF
+ */
+bool ENG_API Eng::PipelineHiZ::render(const glm::mat4 &camera, const glm::mat4 &proj, const Eng::List &list)
+{
+   // Safety net:
+   if (list == Eng::List::empty)
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return false;
+   }
+
+   // Lazy-loading:
+   if (this->isDirty())
+      if (!this->init())
+      {
+         ENG_LOG_ERROR("Unable to render (initialization failed)");
+         return false;
+      }
+
+   // Previous readback still in flight?
+   if (reserved->oglFence)
+      return true;
+
+   // Just to update the cache
+   this->Eng::Pipeline::render(glm::mat4(1.0f), glm::mat4(1.0f), list);
+
+   // Apply program:
+   Eng::Program &program = getProgram();
+   if (program == Eng::Program::empty)
+   {
+      ENG_LOG_ERROR("Invalid program");
+      return false;
+   }
+
+   // Copy the depth buffer:
+   Eng::Base &eng = Eng::Base::getInstance();
+   reserved->fbo.blit(eng.getWindowSize().x, eng.getWindowSize().y, true, true);
+   Eng::Fbo::reset(eng.getWindowSize().x, eng.getWindowSize().y);
+
+   // Reduce it level by level:
+   glBindTextureUnit(0, reserved->depthMap.getOglHandle());
+   Eng::Texture::reset();
+   for (uint32_t c = 0; c <= reserved->readbackLevel; c++)
+   {
+      const uint32_t sizeX = glm::max(1u, reserved->hizMap.getSizeX() >> c);
+      const uint32_t sizeY = glm::max(1u, reserved->hizMap.getSizeY() >> c);
+      reserved->hizMap.bindImage(0, c);
+      if (c > 0)
+         reserved->hizMap.bindImage(1, c - 1);
+      program.render();
+      program.setInt("level", c);
+      program.compute((sizeX + 7) / 8, (sizeY + 7) / 8);
+      glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+   }
+
+   // Start the readback:
+   glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT);
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, reserved->oglPbo);
+   glGetTextureImage(reserved->hizMap.getOglHandle(), reserved->readbackLevel, GL_RED, GL_FLOAT,
+                     static_cast<GLsizei>(reserved->depths.size() * sizeof(float)), nullptr);
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+   reserved->oglFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+   reserved->pendingViewProj = proj * camera;
+
+   // Done:
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Shortcut for using a camera instead of the explicit matrices.
+ * @param camera camera to use
+ * @param list list of renderables
+ * @return TF
+ */
+bool ENG_API Eng::PipelineHiZ::render(const Eng::Camera &camera, const Eng::List &list)
+{
+   return this->render(glm::inverse(camera.getWorldMatrix()), camera.getProjMatrix(), list);
+}
@@ -0,0 +1,64 @@
+/**
+ * @file		engine_pipeline_hiz.h
+ * @brief	A pipeline for hierarchical-Z occlusion culling
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+#pragma once
+
+
+
+/**
+ * @brief Hierarchical-Z (Hi-Z) occlusion culling pipeline. The depth buffer of the current frame is reduced into
+ *        a max-depth mipmap pyramid, a coarse level of which is read back asynchronously and used by cull()
+ *        to mark the occluded elements of the next frame's list.
+ */
+class ENG_API PipelineHiZ final : public Eng::Pipeline
+{
+//////////
+public: //
+//////////
+
+   // Special values:
+   constexpr static uint32_t maxReadbackSize = 128;     ///< Max width of the pyramid level read back to the CPU
+
+
+   // Const/dest:
+	PipelineHiZ();
+	PipelineHiZ(PipelineHiZ &&other);
+   PipelineHiZ(PipelineHiZ const&) = delete;
+   ~PipelineHiZ();
+
+   // Get/set:
+   const Eng::Texture &getHiZMap() const;
+   uint32_t getNrOfCulled() const;
+
+   // Culling:
+   bool cull(Eng::List &list);
+
+   // Rendering methods:
+   bool render(const Eng::Camera &camera, const Eng::List &list) override;
+   bool render(const glm::mat4 &camera, const glm::mat4 &proj, const Eng::List &list) override;
+
+   // Managed:
+   bool init() override;
+   bool free() override;
+
+
+///////////
+private: //
+///////////
+
+   // Reserved:
+   struct Reserved;
+   std::unique_ptr<Reserved> reserved;
+
+   // Const/dest:
+   PipelineHiZ(const std::string &name);
+};
+
+
+
+
+
+
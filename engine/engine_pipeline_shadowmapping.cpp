@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM pipeline
+
    // Main include:
    #include "engine.h"
 
@@ -40,9 +43,18 @@ layout(location = 3) in vec4 a_tangent;
 uniform mat4 modelviewMat;
 uniform mat4 projectionMat;
 
+// Per-instance data (instanced draws only):
+uniform bool instanced;
+layout(std430, binding = 5) readonly buffer InstanceData
+{
+   mat4 instanceMat[];
+};
+
 void main()
 {   
-   gl_Position = projectionMat *  modelviewMat * vec4(a_vertex, 1.0f);
+   mat4 mvMat = instanced ? instanceMat[gl_BaseInstance + gl_InstanceID] : modelviewMat;
+
+   gl_Position = projectionMat *  mvMat * vec4(a_vertex, 1.0f);
 })";
 
 
@@ -247,8 +259,8 @@ bool ENG_API Eng::PipelineShadowMapping::render(const glm::mat4 &camera, const g
    glEnable(GL_CULL_FACE);
    glCullFace(GL_FRONT);
 
-   // Render meshes:   
-   list.render(camera, proj, Eng::List::Pass::meshes);         
+   // Render meshes (occlusion-culled ones still cast shadows):   
+   list.render(camera, proj, Eng::List::Pass::meshes, false);         
 
    // Redo OpenGL settings:
    glCullFace(GL_BACK);
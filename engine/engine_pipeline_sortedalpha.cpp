@@ -0,0 +1,347 @@
+/**
+ * @file		engine_pipeline_sortedalpha.cpp
+ * @brief	A lightweight pipeline for blending back-to-front sorted transparent meshes
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+
+
+
+//////////////
+// #INCLUDE //
+//////////////
+
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM pipeline
+
+   // Main include:
+   #include "engine.h"
+
+   // OGL:
+   #include <GL/glew.h>
+   #include <GLFW/glfw3.h>
+
+
+
+/////////////
+// SHADERS //
+/////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Sorted alpha pipeline vertex shader.
+ */
+static const std::string pipeline_vs = R"(
+
+// Per-vertex data from VBOs:
+layout(location = 0) in vec3 a_vertex;
+layout(location = 1) in vec4 a_normal;
+layout(location = 2) in vec2 a_uv;
+layout(location = 3) in vec4 a_tangent;
+
+// Uniforms:
+uniform mat4 modelviewMat;
+uniform mat4 projectionMat;
+uniform mat3 normalMat;
+
+// Varying:
+out vec4 fragPosition;
+out vec3 normal;
+out vec2 uv;
+
+// Per-instance data (instanced draws only):
+uniform bool instanced;
+layout(std430, binding = 5) readonly buffer InstanceData
+{
+   mat4 instanceMat[];
+};
+
+void main()
+{
+   mat4 mvMat = instanced ? instanceMat[gl_BaseInstance + gl_InstanceID] : modelviewMat;
+   mat3 nMat = instanced ? inverse(transpose(mat3(mvMat))) : normalMat;
+
+   normal = nMat * a_normal.xyz;
+   uv = a_uv;
+
+   fragPosition = mvMat * vec4(a_vertex, 1.0f);
+   gl_Position = projectionMat * fragPosition;
+})";
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Sorted alpha pipeline fragment shader: all the lights are accumulated in a single pass.
+ */
+static const std::string pipeline_fs = R"(
+
+#define MAX_NR_OF_LIGHTS 8
+
+// Uniform:
+#ifdef ENG_BINDLESS_SUPPORTED
+   layout (bindless_sampler) uniform sampler2D texture0; // Albedo
+   layout (bindless_sampler) uniform sampler2D texture1; // Normal
+   layout (bindless_sampler) uniform sampler2D texture2; // Roughness
+   layout (bindless_sampler) uniform sampler2D texture3; // Metalness
+#else
+   layout (binding = 0) uniform sampler2D texture0; // Albedo
+   layout (binding = 1) uniform sampler2D texture1; // Normal
+   layout (binding = 2) uniform sampler2D texture2; // Roughness
+   layout (binding = 3) uniform sampler2D texture3; // Metalness
+#endif
+
+// Uniform (material):
+uniform vec3 mtlEmission;
+uniform vec3 mtlAlbedo;
+uniform float mtlOpacity;
+uniform float mtlRoughness;
+uniform float mtlMetalness;
+
+// Uniform (lights):
+uniform uint totNrOfLights;
+uniform vec3 lightColors[MAX_NR_OF_LIGHTS];
+uniform vec3 lightPositions[MAX_NR_OF_LIGHTS];
+uniform vec3 lightAmbient;
+
+// Varying:
+in vec4 fragPosition;
+in vec3 normal;
+in vec2 uv;
+
+// Output to the framebuffer:
+out vec4 outFragment;
+
+
+//////////
+// MAIN //
+//////////
+
+void main()
+{
+   // Texture lookup:
+   vec4 albedo_texel = texture(texture0, uv);
+   vec4 roughness_texel = mtlRoughness * texture(texture2, uv);
+
+   vec3 fragColor = lightAmbient;
+
+   vec3 N = normalize(normal);
+   vec3 V = normalize(-fragPosition.xyz);
+
+   // Light only front faces:
+   if (dot(N, V) > 0.0f)
+      for (uint i = 0; i < totNrOfLights; i++)
+      {
+         vec3 L = normalize(lightPositions[i] - fragPosition.xyz);
+
+         // Diffuse term:
+         float nDotL = max(0.0f, dot(N, L));
+         fragColor += roughness_texel.r * nDotL * lightColors[i];
+
+         // Specular term:
+         vec3 H = normalize(L + V);
+         float nDotH = max(0.0f, dot(N, H));
+         fragColor += (1.0f - roughness_texel.r) * pow(nDotH, 70.0f) * lightColors[i];
+      }
+
+   outFragment = vec4(mtlEmission + fragColor * albedo_texel.xyz, mtlOpacity);
+})";
+
+
+
+/////////////////////////
+// RESERVED STRUCTURES //
+/////////////////////////
+
+/**
+ * @brief PipelineSortedAlpha reserved structure.
+ */
+struct Eng::PipelineSortedAlpha::Reserved
+{
+   Eng::Shader vs;
+   Eng::Shader fs;
+   Eng::Program program;
+
+
+   /**
+    * Constructor.
+    */
+   Reserved()
+   {}
+};
+
+
+
+///////////////////////////////////////
+// BODY OF CLASS PipelineSortedAlpha //
+///////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Constructor.
+ */
+ENG_API Eng::PipelineSortedAlpha::PipelineSortedAlpha() : reserved(std::make_unique<Eng::PipelineSortedAlpha::Reserved>())
+{
+   ENG_LOG_DETAIL("[+]");
+   this->setProgram(reserved->program);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Constructor with name.
+ * @param name node name
+ */
+ENG_API Eng::PipelineSortedAlpha::PipelineSortedAlpha(const std::string &name) : Eng::Pipeline(name), reserved(std::make_unique<Eng::PipelineSortedAlpha::Reserved>())
+{
+   ENG_LOG_DETAIL("[+]");
+   this->setProgram(reserved->program);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Move constructor.
+ */
+ENG_API Eng::PipelineSortedAlpha::PipelineSortedAlpha(PipelineSortedAlpha &&other) : Eng::Pipeline(std::move(other)), reserved(std::move(other.reserved))
+{
+   ENG_LOG_DETAIL("[M]");
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Destructor.
+ */
+ENG_API Eng::PipelineSortedAlpha::~PipelineSortedAlpha()
+{
+   ENG_LOG_DETAIL("[-]");
+   if (this->isInitialized())
+      free();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Initializes this pipeline.
+ * @return TF
+ */
+bool ENG_API Eng::PipelineSortedAlpha::init()
+{
+   // Already initialized?
+   if (this->Eng::Managed::init() == false)
+      return false;
+   if (!this->isDirty())
+      return false;
+
+   // Build:
+   reserved->vs.load(Eng::Shader::Type::vertex, pipeline_vs);
+   reserved->fs.load(Eng::Shader::Type::fragment, pipeline_fs);
+   if (reserved->program.build({ reserved->vs, reserved->fs }) == false)
+   {
+      ENG_LOG_ERROR("Unable to build sorted alpha program");
+      return false;
+   }
+   this->setProgram(reserved->program);
+
+   // Done:
+   this->setDirty(false);
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Releases this pipeline.
+ * @return TF
+ */
+bool ENG_API Eng::PipelineSortedAlpha::free()
+{
+   if (this->Eng::Managed::free() == false)
+      return false;
+
+   // Done:
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Main rendering method for the pipeline. To be called after the solid meshes have been rendered.
+ * @param camera camera matrix
+ * @param proj projection matrix
+ * @param list list of renderables
+ * @return TF
+ */
+bool ENG_API Eng::PipelineSortedAlpha::render(const glm::mat4 &camera, const glm::mat4 &proj, const Eng::List &list)
+{
+   // Safety net:
+   if (list == Eng::List::empty)
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return false;
+   }
+
+   // Lazy-loading:
+   if (this->isDirty())
+      if (!this->init())
+      {
+         ENG_LOG_ERROR("Unable to render (initialization failed)");
+         return false;
+      }
+
+   // Just to update the cache
+   this->Eng::Pipeline::render(glm::mat4(1.0f), glm::mat4(1.0f), list);
+
+   // Apply program:
+   Eng::Program &program = getProgram();
+   if (program == Eng::Program::empty)
+   {
+      ENG_LOG_ERROR("Invalid program");
+      return false;
+   }
+   program.render();
+   program.setMat4("projectionMat", proj);
+
+   // Pass lights (in eye coords):
+   const uint32_t totNrOfLights = glm::min(list.getNrOfLights(), maxNrOfLights);
+   glm::vec3 ambient(0.0f);
+   for (uint32_t l = 0; l < totNrOfLights; l++)
+   {
+      const Eng::List::RenderableElem &lightRe = list.getRenderableElem(l);
+      const Eng::Light &light = static_cast<const Eng::Light &>(lightRe.reference.get());
+      const std::string index = "[" + std::to_string(l) + "]";
+      program.setVec3("lightPositions" + index, glm::vec3((camera * lightRe.matrix)[3]));
+      program.setVec3("lightColors" + index, light.getColor());
+      ambient += light.getAmbient();
+   }
+   program.setUInt("totNrOfLights", totNrOfLights);
+   program.setVec3("lightAmbient", ambient);
+
+   // Blend on top of the solid meshes, without writing depth:
+   glEnable(GL_BLEND);
+   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+   glDepthMask(GL_FALSE);
+
+   // Render transparent meshes (sorted back-to-front by the list):
+   list.render(camera, proj, Eng::List::Pass::transparents);
+
+   // Redo OpenGL settings:
+   glDepthMask(GL_TRUE);
+   glDisable(GL_BLEND);
+
+   // Done:
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Shortcut for using a camera instead of the explicit matrices.
+ * @param camera camera to use
+ * @param list list of renderables
+ * @return TF
+ */
+bool ENG_API Eng::PipelineSortedAlpha::render(const Eng::Camera &camera, const Eng::List &list)
+{
+   return this->render(glm::inverse(camera.getWorldMatrix()), camera.getProjMatrix(), list);
+}
@@ -0,0 +1,57 @@
+/**
+ * @file		engine_pipeline_sortedalpha.h
+ * @brief	A lightweight pipeline for blending back-to-front sorted transparent meshes
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+#pragma once
+
+
+
+/**
+ * @brief Sorted alpha-blending pipeline. Draws the transparent meshes of the list back-to-front on top of the 
+ *        current framebuffer, in a single pass. Cheaper than PipelineOIT, correct as long as transparent meshes 
+ *        do not intersect each other.
+ */
+class ENG_API PipelineSortedAlpha final : public Eng::Pipeline
+{
+//////////
+public: //
+//////////
+
+   // Special values:
+   constexpr static uint32_t maxNrOfLights = 8;     ///< Max number of lights per pass
+
+
+   // Const/dest:
+	PipelineSortedAlpha();
+	PipelineSortedAlpha(PipelineSortedAlpha &&other);
+   PipelineSortedAlpha(PipelineSortedAlpha const&) = delete;
+   ~PipelineSortedAlpha();
+
+   // Rendering methods:
+   bool render(const Eng::Camera &camera, const Eng::List &list) override;
+   bool render(const glm::mat4 &camera, const glm::mat4 &proj, const Eng::List &list) override;
+
+   // Managed:
+   bool init() override;
+   bool free() override;
+
+
+///////////
+private: //
+///////////
+
+   // Reserved:
+   struct Reserved;
+   std::unique_ptr<Reserved> reserved;
+
+   // Const/dest:
+   PipelineSortedAlpha(const std::string &name);
+};
+
+
+
+
+
+
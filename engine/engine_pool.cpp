@@ -0,0 +1,297 @@
+/**
+ * @file		engine_pool.cpp
+ * @brief	Slab allocator for fixed-size blocks
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+
+
+
+//////////////
+// #INCLUDE //
+//////////////
+
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM core
+
+   // Main include:
+   #include "engine.h"
+
+   // C/C++:
+   #include <new>
+   #include <map>
+   #include <mutex>
+   #include <algorithm>
+
+
+
+////////////
+// STATIC //
+////////////
+
+/**
+ * Gets the registry of the shared pools, indexed by block size and alignment. The registry is never destroyed, as
+ * static objects (e.g., the container singleton) may still release blocks at shutdown.
+ * @return registry
+ */
+static std::map<std::pair<size_t, size_t>, std::unique_ptr<Eng::Pool>> &getRegistry()
+{
+   static std::map<std::pair<size_t, size_t>, std::unique_ptr<Eng::Pool>> &registry = 
+      *new std::map<std::pair<size_t, size_t>, std::unique_ptr<Eng::Pool>>();
+   return registry;
+}
+
+
+/**
+ * Gets the mutex protecting the registry (never destroyed either).
+ * @return mutex
+ */
+static std::mutex &getRegistryMutex()
+{
+   static std::mutex &mutex = *new std::mutex();
+   return mutex;
+}
+
+
+
+/////////////////////////
+// RESERVED STRUCTURES //
+/////////////////////////
+
+/**
+ * @brief Pool reserved structure.
+ */
+struct Eng::Pool::Reserved
+{
+   size_t blockSize;             ///< Block size, padded to the alignment and large enough to store a free-list link
+   size_t blockAlign;
+   uint32_t slabSize;
+   std::vector<void *> slabs;
+   void *freeList;               ///< Head of the singly-linked list of free blocks
+   uint64_t nrOfBlocks;          ///< Blocks currently in use
+   std::mutex mutex;             ///< Objects can be created and destroyed by any thread
+
+
+   /**
+    * Constructor.
+    */
+   Reserved() : blockSize{ 0 }, blockAlign{ 0 }, slabSize{ 0 }, freeList{ nullptr }, nrOfBlocks{ 0 }
+   {}
+
+
+   /**
+    * Allocates a new slab and threads its blocks into the free list, in address order.
+    */
+   void addSlab()
+   {
+      uint8_t *slab = static_cast<uint8_t *>(::operator new(blockSize * slabSize, std::align_val_t(blockAlign)));
+      slabs.push_back(slab);
+      for (uint32_t c = slabSize; c > 0; c--)
+      {
+         void *block = slab + (c - 1) * blockSize;
+         *static_cast<void **>(block) = freeList;
+         freeList = block;
+      }
+   }
+
+
+   /**
+    * Releases the slabs whose blocks are all free, removing their blocks from the free list.
+    * @return number of slabs released
+    */
+   uint32_t releaseFreeSlabs()
+   {
+      // Find the slab of each free block (slabs sorted by address):
+      std::sort(slabs.begin(), slabs.end(), std::less<void *>());
+      std::vector<std::pair<void *, size_t>> freeBlocks;
+      std::vector<uint32_t> nrOfFree(slabs.size(), 0);
+      for (void *block = freeList; block; block = *static_cast<void **>(block))
+      {
+         const size_t slab = std::upper_bound(slabs.begin(), slabs.end(), block, std::less<void *>()) - slabs.begin() - 1;
+         freeBlocks.push_back({ block, slab });
+         nrOfFree[slab]++;
+      }
+
+      // Rebuild the free list (same order) with the blocks of the slabs still in use:
+      freeList = nullptr;
+      for (auto it = freeBlocks.rbegin(); it != freeBlocks.rend(); ++it)
+         if (nrOfFree[it->second] != slabSize)
+         {
+            *static_cast<void **>(it->first) = freeList;
+            freeList = it->first;
+         }
+
+      // Release the others:
+      uint32_t nrOfReleased = 0;
+      for (size_t c = 0; c < slabs.size(); c++)
+         if (nrOfFree[c] == slabSize)
+         {
+            ::operator delete(slabs[c], std::align_val_t(blockAlign));
+            nrOfReleased++;
+         }
+         else
+            slabs[c - nrOfReleased] = slabs[c];
+      slabs.resize(slabs.size() - nrOfReleased);
+      return nrOfReleased;
+   }
+
+
+   /**
+    * Releases all the slabs.
+    */
+   void releaseSlabs()
+   {
+      for (void *slab : slabs)
+         ::operator delete(slab, std::align_val_t(blockAlign));
+      slabs.clear();
+      freeList = nullptr;
+   }
+};
+
+
+
+////////////////////////
+// BODY OF CLASS Pool //
+////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Constructor.
+ * @param blockSize size of a block in bytes
+ * @param blockAlign alignment of a block in bytes
+ * @param slabSize nr. of blocks per slab
+ */
+ENG_API Eng::Pool::Pool(size_t blockSize, size_t blockAlign, uint32_t slabSize) : reserved(std::make_unique<Eng::Pool::Reserved>())
+{
+   reserved->blockAlign = std::max(blockAlign, alignof(void *));
+   reserved->blockSize = std::max(blockSize, sizeof(void *));
+   reserved->blockSize = (reserved->blockSize + reserved->blockAlign - 1) / reserved->blockAlign * reserved->blockAlign;
+   reserved->slabSize = std::max(slabSize, 1u);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Destructor.
+ */
+ENG_API Eng::Pool::~Pool()
+{
+   reserved->releaseSlabs();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the shared pool for blocks of the given size and alignment, creating it when needed.
+ * @param blockSize size of a block in bytes
+ * @param blockAlign alignment of a block in bytes
+ * @return pool
+ */
+Eng::Pool ENG_API &Eng::Pool::get(size_t blockSize, size_t blockAlign)
+{
+   std::lock_guard<std::mutex> lock(getRegistryMutex());
+   std::unique_ptr<Eng::Pool> &pool = getRegistry()[{ blockSize, blockAlign }];
+   if (pool == nullptr)
+      pool = std::make_unique<Eng::Pool>(blockSize, blockAlign);
+   return *pool;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Releases the slabs with no blocks in use of all the shared pools.
+ */
+void ENG_API Eng::Pool::trimAll()
+{
+   std::lock_guard<std::mutex> lock(getRegistryMutex());
+   for (auto &pool : getRegistry())
+      pool.second->trim();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the padded size of the blocks.
+ * @return block size in bytes
+ */
+size_t ENG_API Eng::Pool::getBlockSize() const
+{
+   return reserved->blockSize;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of blocks currently in use.
+ * @return number of blocks
+ */
+uint64_t ENG_API Eng::Pool::getNrOfBlocks() const
+{
+   return reserved->nrOfBlocks;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of slabs currently allocated.
+ * @return number of slabs
+ */
+uint64_t ENG_API Eng::Pool::getNrOfSlabs() const
+{
+   return reserved->slabs.size();
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Allocates a block, adding a new slab when the free list is exhausted.
+ * @return pointer to uninitialized storage
+ */
+void ENG_API *Eng::Pool::allocate()
+{
+   std::lock_guard<std::mutex> lock(reserved->mutex);
+   if (reserved->freeList == nullptr)
+      reserved->addSlab();
+
+   void *block = reserved->freeList;
+   reserved->freeList = *static_cast<void **>(block);
+   reserved->nrOfBlocks++;
+   return block;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns a block to the pool.
+ * @param ptr block previously obtained through allocate()
+ */
+void ENG_API Eng::Pool::deallocate(void *ptr)
+{
+   if (ptr == nullptr)
+      return;
+
+   std::lock_guard<std::mutex> lock(reserved->mutex);
+   *static_cast<void **>(ptr) = reserved->freeList;
+   reserved->freeList = ptr;
+   reserved->nrOfBlocks--;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Releases the slabs with no block in use (all of them at once when the pool is empty). Slabs still holding a 
+ * block, e.g. of a static object, are kept.
+ * @return TF when at least one slab was released
+ */
+bool ENG_API Eng::Pool::trim()
+{
+   std::lock_guard<std::mutex> lock(reserved->mutex);
+   if (reserved->nrOfBlocks == 0)
+   {
+      const bool released = !reserved->slabs.empty();
+      reserved->releaseSlabs();
+      return released;
+   }
+
+   return reserved->releaseFreeSlabs() > 0;
+}
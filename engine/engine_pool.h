@@ -0,0 +1,136 @@
+/**
+ * @file		engine_pool.h
+ * @brief	Slab allocator for fixed-size blocks
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+#pragma once
+
+
+
+/////////////
+// #DEFINE //
+/////////////
+
+   // Class-specific new/delete operators serving the enclosing structure from its pool:
+   #define ENG_POOLED(T) \
+      static void *operator new(size_t) { static Eng::Pool &pool = Eng::Pool::get(sizeof(T), alignof(T)); return pool.allocate(); } \
+      static void operator delete(void *ptr) { static Eng::Pool &pool = Eng::Pool::get(sizeof(T), alignof(T)); pool.deallocate(ptr); }
+
+
+
+/**
+ * @brief Slab allocator for fixed-size blocks. Blocks are carved out of large slabs and recycled through a free list,
+ *        so their addresses stay stable for their whole lifetime. Pools are shared per block size/alignment and 
+ *        retrieved through get(). Thread-safe.
+ */
+class ENG_API Pool final
+{
+//////////
+public: //
+//////////
+
+   // Special values:
+   constexpr static uint32_t defaultSlabSize = 64;     ///< Nr. of blocks per slab
+
+   // Const/dest:
+   Pool(size_t blockSize, size_t blockAlign, uint32_t slabSize = defaultSlabSize);
+   Pool(Pool const &) = delete;
+   ~Pool();
+
+   // Registry:
+   static Pool &get(size_t blockSize, size_t blockAlign);
+   static void trimAll();
+
+   // Get/set:
+   size_t getBlockSize() const;
+   uint64_t getNrOfBlocks() const;
+   uint64_t getNrOfSlabs() const;
+
+   // Allocation:
+   void *allocate();
+   void deallocate(void *ptr);
+   bool trim();
+
+
+///////////
+private: //
+///////////
+
+   // Reserved:
+   struct Reserved;
+   std::unique_ptr<Reserved> reserved;
+};
+
+
+
+/**
+ * @brief Standard allocator serving single-element requests from the pool matching T (e.g., std::list nodes).
+ */
+template <typename T> class PoolAllocator
+{
+//////////
+public: //
+//////////
+
+   using value_type = T;
+
+   // Const/dest:
+   PoolAllocator() noexcept = default;
+   template <typename U> PoolAllocator(const PoolAllocator<U> &) noexcept {}
+
+
+   /**
+    * Allocates storage for n elements: single elements come from the pool, arrays from the heap.
+    * @param n number of elements
+    * @return pointer to uninitialized storage
+    */
+   T *allocate(size_t n)
+   {
+      if (n != 1)
+         return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+      return static_cast<T *>(getPool().allocate());
+   }
+
+
+   /**
+    * Releases storage previously obtained through allocate().
+    * @param ptr storage
+    * @param n number of elements
+    */
+   void deallocate(T *ptr, size_t n) noexcept
+   {
+      if (n != 1)
+         ::operator delete(ptr, std::align_val_t(alignof(T)));
+      else
+         getPool().deallocate(ptr);
+   }
+
+
+   // Operators:
+   template <typename U> bool operator==(const PoolAllocator<U> &) const noexcept { return true; }
+   template <typename U> bool operator!=(const PoolAllocator<U> &) const noexcept { return false; }
+
+
+///////////
+private: //
+///////////
+
+   /**
+    * Gets the pool matching T.
+    * @return pool
+    */
+   static Pool &getPool()
+   {
+      static Pool &pool = Pool::get(sizeof(T), alignof(T));
+      return pool;
+   }
+};
+
+
+
+/**
+ * @brief List whose nodes are allocated from a pool.
+ */
+template <typename T> using PooledList = std::list<T, PoolAllocator<T>>;
+
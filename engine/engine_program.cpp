@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM resource
+
    // Main include:
    #include "engine.h"
 
@@ -119,7 +122,7 @@ bool ENG_API Eng::Program::init()
    // Free program if stored:
    if (reserved->oglId)   
    {  
-      glDeleteProgram(reserved->oglId);      
+      Eng::Managed::release(Eng::Managed::Resource::program, reserved->oglId);      
       reserved->oglId = 0;
    }   
 	
@@ -149,7 +152,7 @@ bool ENG_API Eng::Program::free()
    // Free shader if stored:
    if (reserved->oglId)   
    {
-      glDeleteProgram(reserved->oglId);      
+      Eng::Managed::release(Eng::Managed::Resource::program, reserved->oglId);      
       reserved->oglId = 0;
    }   
 
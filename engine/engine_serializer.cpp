@@ -11,11 +11,21 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM loader
+
    // Main include:
    #include "engine.h"
 
    // C/C++:
    #include <iterator>
+   #include <algorithm>
+
+   // SIMD (always available on x64):
+   #if defined(__SSE2__) || defined(_M_X64)
+      #include <emmintrin.h>
+      #define ENG_SERIALIZER_SSE2
+   #endif
 
 
 
@@ -26,6 +36,205 @@
    // Special values:
    Eng::Serializer Eng::Serializer::empty;
 
+   // LZ stage:
+   constexpr uint32_t lzMinMatch = 4;           ///< Shortest match encoded
+   constexpr uint32_t lzHashBits = 14;          ///< Size of the match finder table (log2)
+   constexpr uint32_t lzMaxOffset = 0xffff;     ///< Farthest match encoded
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Compresses a buffer with a greedy LZ77 coder (LZ4-like sequences: a token with the literal and match lengths, 
+ * the literals, a 16-bit offset, then the length extensions). The last sequence holds literals only.
+ * @param src data to compress
+ * @param nrOfBytes size of the data
+ * @param dst compressed data (appended)
+ */
+static void lzCompress(const uint8_t *src, uint32_t nrOfBytes, std::vector<uint8_t> &dst)
+{
+   std::vector<int32_t> table(1 << lzHashBits, -1);
+   uint32_t anchor = 0, pos = 0;
+
+   auto putLength = [&dst](uint32_t length)
+   {
+      for (; length >= 255; length -= 255)
+         dst.push_back(255);
+      dst.push_back(static_cast<uint8_t>(length));
+   };
+   auto putSequence = [&](uint32_t literalsEnd, uint32_t matchLength, uint32_t offset)
+   {
+      const uint32_t nrOfLiterals = literalsEnd - anchor;
+      const uint32_t extraLength = matchLength ? matchLength - lzMinMatch : 0;
+      dst.push_back(static_cast<uint8_t>((std::min(nrOfLiterals, 15u) << 4) | std::min(extraLength, 15u)));
+      if (nrOfLiterals >= 15)
+         putLength(nrOfLiterals - 15);
+      dst.insert(dst.end(), src + anchor, src + literalsEnd);
+      if (matchLength == 0)
+         return;
+      dst.push_back(static_cast<uint8_t>(offset & 0xff));
+      dst.push_back(static_cast<uint8_t>(offset >> 8));
+      if (extraLength >= 15)
+         putLength(extraLength - 15);
+   };
+
+   while (pos + lzMinMatch <= nrOfBytes)
+   {
+      uint32_t sequence;
+      memcpy(&sequence, src + pos, sizeof(uint32_t));
+      const uint32_t hash = (sequence * 2654435761u) >> (32 - lzHashBits);
+      const int32_t candidate = table[hash];
+      table[hash] = static_cast<int32_t>(pos);
+      if (candidate < 0 || pos - candidate > lzMaxOffset || memcmp(src + candidate, src + pos, lzMinMatch))
+      {
+         pos++;
+         continue;
+      }
+
+      uint32_t length = lzMinMatch;
+      while (pos + length < nrOfBytes && src[candidate + length] == src[pos + length])
+         length++;
+      putSequence(pos, length, pos - candidate);
+      pos += length;
+      anchor = pos;
+   }
+   putSequence(nrOfBytes, 0, 0);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Decompresses a buffer written by lzCompress(), with bounds checks on both sides.
+ * @param src compressed data
+ * @param srcSize size of the compressed data
+ * @param dst output buffer
+ * @param nrOfBytes expected size of the decompressed data
+ * @return TF
+ */
+static bool lzDecompress(const uint8_t *src, uint32_t srcSize, uint8_t *dst, uint32_t nrOfBytes)
+{
+   const uint8_t *srcEnd = src + srcSize;
+   uint32_t pos = 0;
+
+   auto getLength = [&src, srcEnd](uint32_t &length)
+   {
+      uint8_t extra = 255;
+      while (extra == 255 && src < srcEnd)
+      {
+         extra = *src++;
+         length += extra;
+      }
+      return extra != 255;
+   };
+
+   while (pos < nrOfBytes)
+   {
+      if (src >= srcEnd)
+         return false;
+      const uint8_t token = *src++;
+
+      // Literals:
+      uint32_t nrOfLiterals = token >> 4;
+      if (nrOfLiterals == 15 && !getLength(nrOfLiterals))
+         return false;
+      if (nrOfLiterals > static_cast<uint32_t>(srcEnd - src) || nrOfLiterals > nrOfBytes - pos)
+         return false;
+      memcpy(dst + pos, src, nrOfLiterals);
+      src += nrOfLiterals;
+      pos += nrOfLiterals;
+      if (pos == nrOfBytes)
+         break;
+
+      // Match:
+      if (srcEnd - src < 2)
+         return false;
+      const uint32_t offset = src[0] | (src[1] << 8);
+      src += 2;
+      uint32_t length = token & 0x0f;
+      if (length == 15 && !getLength(length))
+         return false;
+      length += lzMinMatch;
+      if (offset == 0 || offset > pos || length > nrOfBytes - pos)
+         return false;
+      if (offset >= length)
+         memcpy(dst + pos, dst + pos - offset, length);
+      else
+         for (uint32_t c = 0; c < length; c++)
+            dst[pos + c] = dst[pos + c - offset];
+      pos += length;
+   }
+
+   // Done:
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Rebuilds a column of 32-bit words from its four byte planes, undoing the zigzag/delta coding when required, and
+ * stores it into strided elements. Sixteen words per iteration on SSE2.
+ * @param planes four consecutive byte planes of count bytes each (lowest byte first)
+ * @param count number of words
+ * @param delta true when the words are zigzag-coded deltas
+ * @param dst first word of the column
+ * @param stride distance between two words of the column
+ */
+static void decodeColumn(const uint8_t *planes, uint32_t count, bool delta, uint8_t *dst, uint32_t stride)
+{
+   const uint8_t *p0 = planes, *p1 = p0 + count, *p2 = p1 + count, *p3 = p2 + count;
+   uint32_t c = 0, previous = 0;
+
+#ifdef ENG_SERIALIZER_SSE2
+   const __m128i one = _mm_set1_epi32(1);
+   __m128i carry = _mm_setzero_si128();
+   for (; c + 16 <= count; c += 16)
+   {
+      const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p0 + c));
+      const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p1 + c));
+      const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p2 + c));
+      const __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p3 + c));
+      const __m128i lo01 = _mm_unpacklo_epi8(b0, b1), hi01 = _mm_unpackhi_epi8(b0, b1);
+      const __m128i lo23 = _mm_unpacklo_epi8(b2, b3), hi23 = _mm_unpackhi_epi8(b2, b3);
+      __m128i words[4] = { _mm_unpacklo_epi16(lo01, lo23), _mm_unpackhi_epi16(lo01, lo23),
+                           _mm_unpacklo_epi16(hi01, hi23), _mm_unpackhi_epi16(hi01, hi23) };
+      for (uint32_t k = 0; k < 4; k++)
+      {
+         // Zigzag, then prefix sum within the register plus the running total:
+         if (delta)
+         {
+            __m128i w = _mm_xor_si128(_mm_srli_epi32(words[k], 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(words[k], one)));
+            w = _mm_add_epi32(w, _mm_slli_si128(w, 4));
+            w = _mm_add_epi32(w, _mm_slli_si128(w, 8));
+            words[k] = _mm_add_epi32(w, carry);
+            carry = _mm_shuffle_epi32(words[k], _MM_SHUFFLE(3, 3, 3, 3));
+         }
+
+         uint8_t *out = dst + static_cast<uint64_t>(c + k * 4) * stride;
+         if (stride == sizeof(uint32_t))
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), words[k]);
+         else
+         {
+            alignas(16) uint32_t lanes[4];
+            _mm_store_si128(reinterpret_cast<__m128i *>(lanes), words[k]);
+            for (uint32_t l = 0; l < 4; l++)
+               memcpy(out + l * stride, &lanes[l], sizeof(uint32_t));
+         }
+      }
+   }
+   previous = static_cast<uint32_t>(_mm_cvtsi128_si32(carry));
+#endif
+
+   for (; c < count; c++)
+   {
+      uint32_t word = p0[c] | (p1[c] << 8) | (p2[c] << 16) | (static_cast<uint32_t>(p3[c]) << 24);
+      if (delta)
+      {
+         word = previous + ((word >> 1) ^ (0u - (word & 1)));
+         previous = word;
+      }
+      memcpy(dst + static_cast<uint64_t>(c) * stride, &word, sizeof(uint32_t));
+   }
+}
+
 
 
 /////////////////////////
@@ -154,6 +363,17 @@ uint64_t ENG_API Eng::Serializer::getNrOfBytes() const
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Returns the number of bytes still to be deserialized.
+ * @return number of bytes after the current position
+ */
+uint64_t ENG_API Eng::Serializer::getNrOfRemainingBytes() const
+{
+   return reserved->position < reserved->nrOfBytes ? reserved->nrOfBytes - reserved->position : 0;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Resets the internal data. 
@@ -332,3 +552,272 @@ bool ENG_API Eng::Serializer::deserialize(void *rawData, uint64_t nrOfBytes)
    // Done:
    return true;
 }
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Consumes a block of bytes with a single bounds check. Used by the schema-based readers.
+ * @param nrOfBytes number of bytes
+ * @return pointer to the block (valid until the serializer is modified), or nullptr on overflow
+ */
+const void ENG_API *Eng::Serializer::consume(uint64_t nrOfBytes)
+{
+   if (reserved->position > reserved->nrOfBytes || nrOfBytes > reserved->nrOfBytes - reserved->position)
+   {
+      ENG_LOG_ERROR("Buffer overflow");
+      return nullptr;
+   }
+
+   const void *ptr = reserved->data.data() + reserved->position;
+   reserved->position += nrOfBytes;
+
+   // Done:
+   return ptr;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a string (null-terminated).
+ * @param text string to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(const std::string &text)
+{
+   return serialize(text.c_str(), text.size() + 1);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a byte.
+ * @param byte byte to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(uint8_t byte)
+{
+   return serialize(&byte, sizeof(uint8_t));
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a boolean.
+ * @param _bool boolean to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(bool _bool)
+{
+   return serialize(&_bool, sizeof(bool));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a uint.
+ * @param uint unsigned int to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(uint32_t uint)
+{
+   return serialize(&uint, sizeof(uint32_t));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a float.
+ * @param _float float to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(float _float)
+{
+   return serialize(&_float, sizeof(float));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a vec3.
+ * @param vec vec3 to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(const glm::vec3 &vec)
+{
+   return serialize(&vec, sizeof(glm::vec3));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a vec4.
+ * @param vec vec4 to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(const glm::vec4 &vec)
+{
+   return serialize(&vec, sizeof(glm::vec4));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a mat4.
+ * @param mat mat4 to serialize
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(const glm::mat4 &mat)
+{
+   return serialize(&mat, sizeof(glm::mat4));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes a series of raw bytes, appended at the end of the stored data.
+ * @param rawData pointer to data
+ * @param nrOfBytes number of bytes
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serialize(const void *rawData, uint64_t nrOfBytes)
+{
+   // Safety net:
+   if (rawData == nullptr && nrOfBytes)
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return false;
+   }
+
+   // Append:
+   const uint8_t *ptr = static_cast<const uint8_t *>(rawData);
+   reserved->data.resize(reserved->nrOfBytes);
+   reserved->data.insert(reserved->data.end(), ptr, ptr + nrOfBytes);
+   reserved->nrOfBytes += nrOfBytes;
+
+   // Done:
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Serializes an array of elements as a compressed stream. Elements are seen as columns of 32-bit words: each column
+ * is optionally delta-coded (zigzag, for integers changing slowly, such as indices), then split into byte planes 
+ * and LZ-compressed. Blocks of streamBlockSize elements are coded independently, so that they can be decoded in 
+ * parallel.
+ * @param elements pointer to the elements
+ * @param nrOfElements number of elements
+ * @param stride size of an element, in bytes (multiple of 4)
+ * @param delta true to delta-code the words
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::serializeStream(const void *elements, uint32_t nrOfElements, uint32_t stride, bool delta)
+{
+   // Safety net:
+   if ((elements == nullptr && nrOfElements) || stride == 0 || stride % sizeof(uint32_t))
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return false;
+   }
+
+   const uint32_t nrOfBlocks = (nrOfElements + streamBlockSize - 1) / streamBlockSize;
+   const uint32_t nrOfWords = stride / sizeof(uint32_t);
+   const uint8_t *src = static_cast<const uint8_t *>(elements);
+
+   std::vector<std::vector<uint8_t>> blocks(nrOfBlocks);
+   Eng::Jobs::getInstance().parallelFor(nrOfBlocks, 1, [&](uint32_t begin, uint32_t end)
+   {
+      std::vector<uint8_t> planes;
+      for (uint32_t b = begin; b < end; b++)
+      {
+         const uint32_t first = b * streamBlockSize, count = std::min(streamBlockSize, nrOfElements - first);
+         planes.resize(static_cast<size_t>(count) * stride);
+         for (uint32_t w = 0; w < nrOfWords; w++)
+         {
+            uint8_t *plane = planes.data() + static_cast<size_t>(w) * sizeof(uint32_t) * count;
+            uint32_t previous = 0;
+            for (uint32_t c = 0; c < count; c++)
+            {
+               uint32_t word;
+               memcpy(&word, src + (static_cast<uint64_t>(first) + c) * stride + w * sizeof(uint32_t), sizeof(uint32_t));
+               if (delta)
+               {
+                  const uint32_t diff = word - previous;
+                  previous = word;
+                  word = (diff << 1) ^ (0u - (diff >> 31));
+               }
+               for (uint32_t k = 0; k < sizeof(uint32_t); k++)
+                  plane[k * count + c] = static_cast<uint8_t>(word >> (k * 8));
+            }
+         }
+         lzCompress(planes.data(), static_cast<uint32_t>(planes.size()), blocks[b]);
+      }
+   });
+
+   // Block table, then blocks:
+   bool done = serialize(nrOfBlocks);
+   for (auto &block : blocks)
+      done = done && serialize(static_cast<uint32_t>(block.size()));
+   for (auto &block : blocks)
+      done = done && serialize(block.data(), block.size());
+
+   // Done:
+   return done;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Deserializes a stream written by serializeStream(). Blocks are decoded in parallel through the job system.
+ * @param elements pointer to the output elements
+ * @param nrOfElements number of elements (must match the stream)
+ * @param stride size of an element, in bytes (multiple of 4)
+ * @param delta true when the words were delta-coded
+ * @return TF
+ */
+bool ENG_API Eng::Serializer::deserializeStream(void *elements, uint32_t nrOfElements, uint32_t stride, bool delta)
+{
+   // Safety net:
+   if ((elements == nullptr && nrOfElements) || stride == 0 || stride % sizeof(uint32_t))
+   {
+      ENG_LOG_ERROR("Invalid params");
+      return false;
+   }
+
+   // Block table:
+   uint32_t nrOfBlocks;
+   Span<uint32_t> sizes;
+   if (!deserialize(nrOfBlocks) || nrOfBlocks != (nrOfElements + streamBlockSize - 1) / streamBlockSize || 
+       !read(sizes, nrOfBlocks))
+   {
+      ENG_LOG_ERROR("Invalid stream");
+      return false;
+   }
+   std::vector<uint64_t> offsets(nrOfBlocks + 1, 0);
+   for (uint32_t b = 0; b < nrOfBlocks; b++)
+      offsets[b + 1] = offsets[b] + sizes[b];
+   const uint8_t *src = static_cast<const uint8_t *>(consume(offsets.back()));
+   if (src == nullptr)
+      return false;
+
+   const uint32_t nrOfWords = stride / sizeof(uint32_t);
+   uint8_t *dst = static_cast<uint8_t *>(elements);
+   std::atomic<bool> valid{ true };
+   Eng::Jobs::getInstance().parallelFor(nrOfBlocks, 1, [&](uint32_t begin, uint32_t end)
+   {
+      std::vector<uint8_t> planes;
+      for (uint32_t b = begin; b < end; b++)
+      {
+         const uint32_t first = b * streamBlockSize, count = std::min(streamBlockSize, nrOfElements - first);
+         planes.resize(static_cast<size_t>(count) * stride);
+         if (!lzDecompress(src + offsets[b], sizes[b], planes.data(), static_cast<uint32_t>(planes.size())))
+         {
+            valid = false;
+            continue;
+         }
+         for (uint32_t w = 0; w < nrOfWords; w++)
+            decodeColumn(planes.data() + static_cast<size_t>(w) * sizeof(uint32_t) * count, count, delta,
+                         dst + static_cast<uint64_t>(first) * stride + w * sizeof(uint32_t), stride);
+      }
+   });
+   if (!valid)
+   {
+      ENG_LOG_ERROR("Corrupted stream");
+      return false;
+   }
+
+   // Done:
+   return true;
+}
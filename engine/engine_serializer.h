@@ -19,6 +19,55 @@ public: //
 
    // Special values:
    static Serializer empty;      
+   constexpr static uint32_t streamBlockSize = 16384;    ///< Elements per independently compressed block of a stream
+   constexpr static uint32_t maxStreamRatio = 255;       ///< Upper bound of the decoded/encoded size of a stream
+
+
+   /**
+    * @brief Packed layout of a fixed-size block, as a compile-time list of members of S (in storage order).
+    *        The whole block is bounds-checked once and copied field by field with constant-size copies.
+    */
+   template <typename S, typename... T> struct Schema
+   {
+      static_assert(sizeof...(T) > 0, "Empty schema");
+      static_assert((std::is_trivially_copyable<T>::value && ...), "Schema fields must be trivially copyable");
+
+      static constexpr uint64_t nrOfBytes = (sizeof(T) + ...);   ///< Size of the packed block
+      std::tuple<T S::*...> fields;                              ///< Members, in storage order
+   };
+
+
+   /**
+    * Builds a schema from a list of members.
+    * @param fields pointers to the members of S, in storage order
+    * @return schema
+    */
+   template <typename S, typename... T> static constexpr Schema<S, T...> schema(T S::*... fields)
+   {
+      return Schema<S, T...>{ std::tuple<T S::*...>(fields...) };
+   }
+
+
+   /**
+    * @brief Read-only view over a packed array stored in a serializer (valid until the serializer is modified). 
+    *        Elements are copied out, so the array does not need to be aligned.
+    */
+   template <typename T> class Span
+   {
+   public:
+      Span() : bytes{ nullptr }, count{ 0 } {}
+      Span(const void *bytes, uint64_t count) : bytes{ static_cast<const uint8_t *>(bytes) }, count{ count } {}
+
+      uint64_t size() const { return count; }
+      bool empty() const { return count == 0; }
+      const void *data() const { return bytes; }
+      T operator[](uint64_t id) const { T value; memcpy(&value, bytes + id * sizeof(T), sizeof(T)); return value; }
+      void copyTo(T *dst) const { if (count) memcpy(dst, bytes, count * sizeof(T)); }
+
+   private:
+      const uint8_t *bytes;
+      uint64_t count;
+   };
 
    // Const/dest:
    Serializer();   
@@ -33,6 +82,7 @@ public: //
    void *getData() const;
    void *getDataAtCurPos() const;
    uint64_t getNrOfBytes() const;
+   uint64_t getNrOfRemainingBytes() const;
 
    // Serialization:
    void clear();
@@ -46,6 +96,83 @@ public: //
    bool deserialize(glm::vec4 &vec);
    bool deserialize(glm::mat4 &mat);
    bool deserialize(void *rawData, uint64_t nrOfBytes);   
+   bool serialize(const std::string &text);
+   bool serialize(uint8_t byte);
+   bool serialize(bool _bool);
+   bool serialize(uint32_t uint);
+   bool serialize(float _float);
+   bool serialize(const glm::vec3 &vec);
+   bool serialize(const glm::vec4 &vec);
+   bool serialize(const glm::mat4 &mat);
+   bool serialize(const void *rawData, uint64_t nrOfBytes);
+
+   // Schema-based serialization:
+   const void *consume(uint64_t nrOfBytes);
+
+   // Compressed streams:
+   bool deserializeStream(void *elements, uint32_t nrOfElements, uint32_t stride, bool delta = false);
+   bool serializeStream(const void *elements, uint32_t nrOfElements, uint32_t stride, bool delta = false);
+
+
+   /**
+    * Deserializes a fixed-size block described by a schema.
+    * @param block structure to fill
+    * @param schema layout of the block
+    * @return TF
+    */
+   template <typename S, typename... T> bool read(S &block, const Schema<S, T...> &schema)
+   {
+      const uint8_t *src = static_cast<const uint8_t *>(consume(Schema<S, T...>::nrOfBytes));
+      if (src == nullptr)
+         return false;
+      std::apply([&block, &src](auto... field) 
+      { 
+         ((memcpy(&(block.*field), src, sizeof(block.*field)), src += sizeof(block.*field)), ...); 
+      }, schema.fields);
+      return true;
+   }
+
+
+   /**
+    * Deserializes a packed array without copying it.
+    * @param span view over the array
+    * @param count number of elements
+    * @return TF
+    */
+   template <typename T> bool read(Span<T> &span, uint64_t count)
+   {
+      static_assert(std::is_trivially_copyable<T>::value, "Span elements must be trivially copyable");
+      if (count == 0)
+      {
+         span = Span<T>();
+         return true;
+      }
+      if (count > UINT64_MAX / sizeof(T))
+         return false;
+      const void *src = consume(count * sizeof(T));
+      if (src == nullptr)
+         return false;
+      span = Span<T>(src, count);
+      return true;
+   }
+
+
+   /**
+    * Serializes a fixed-size block described by a schema.
+    * @param block structure to store
+    * @param schema layout of the block
+    * @return TF
+    */
+   template <typename S, typename... T> bool write(const S &block, const Schema<S, T...> &schema)
+   {
+      uint8_t buffer[Schema<S, T...>::nrOfBytes];
+      uint8_t *dst = buffer;
+      std::apply([&block, &dst](auto... field) 
+      { 
+         ((memcpy(dst, &(block.*field), sizeof(block.*field)), dst += sizeof(block.*field)), ...); 
+      }, schema.fields);
+      return serialize(buffer, sizeof(buffer));
+   }
 
 
 ///////////
@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM resource
+
    // Main include:
    #include "engine.h"
 
@@ -112,7 +115,7 @@ bool ENG_API Eng::Shader::init()
    // Free shader if stored:
    if (reserved->oglId)
    {
-      glDeleteShader(reserved->oglId);
+      Eng::Managed::release(Eng::Managed::Resource::shader, reserved->oglId);
       reserved->oglId = 0;
    }
 
@@ -157,7 +160,7 @@ bool ENG_API Eng::Shader::free()
    // Free shader if stored:
    if (reserved->oglId)
    {
-      glDeleteShader(reserved->oglId);
+      Eng::Managed::release(Eng::Managed::Resource::shader, reserved->oglId);
       reserved->oglId = 0;
    }
 
@@ -10,6 +10,9 @@
 // #INCLUDE //
 //////////////
 
+// Logging subsystem:
+#define ENG_LOG_SUBSYSTEM resource
+
 // Main include:
 #include "engine.h"
 #include "engine_ssbo.h"
@@ -133,7 +136,7 @@ bool ENG_API Eng::Ssbo::init()
     // Free buffer if already stored:
     if (reserved->oglId)
     {
-        glDeleteBuffers(1, &reserved->oglId);
+        Eng::Managed::release(Eng::Managed::Resource::buffer, reserved->oglId);
         reserved->oglId = 0;
         reserved->size = 0;
     }
@@ -159,7 +162,7 @@ bool ENG_API Eng::Ssbo::free()
     // Free SSBO if stored:
     if (reserved->oglId)
     {
-        glDeleteBuffers(1, &reserved->oglId);
+        Eng::Managed::release(Eng::Managed::Resource::buffer, reserved->oglId);
         reserved->oglId = 0;
         reserved->size = 0;
     }
@@ -194,6 +197,7 @@ bool ENG_API Eng::Ssbo::create(uint64_t size, const void* data)
 
     // Done:
     reserved->size = size;
+    this->setMemoryUsage(MemoryType::storageBuffer, size);
     return true;
 }
 
@@ -215,6 +219,31 @@ bool ENG_API Eng::Ssbo::create(uint64_t size, const void* data, const GLbitfield
 
     // Done:
     reserved->size = size;
+    this->setMemoryUsage(MemoryType::storageBuffer, size);
+    return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Updates (part of) the content of a buffer created with non-immutable storage flags.
+ * @param size size in bytes of the data to copy
+ * @param data pointer to the data to copy into the buffer
+ * @param offset destination offset in bytes
+ * @return TF
+ */
+bool ENG_API Eng::Ssbo::update(uint64_t size, const void* data, uint64_t offset)
+{
+    // Safety net:
+    if (data == nullptr || offset + size > reserved->size)
+    {
+        ENG_LOG_ERROR("Invalid params");
+        return false;
+    }
+
+    glNamedBufferSubData(reserved->oglId, offset, size, data);
+
+    // Done:
     return true;
 }
 
@@ -46,6 +46,7 @@ namespace Eng
         // Data:
         bool create(uint64_t size, const void* data = nullptr);
         bool create(uint64_t size, const void* data, GLbitfield flags);
+        bool update(uint64_t size, const void* data, uint64_t offset = 0);
         void* map(Mapping mapping);
         bool unmap();
 
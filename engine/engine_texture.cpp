@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM texture
+
    // Main include:
    #include "engine.h"
 
@@ -27,6 +30,9 @@
    // Special values:
    Eng::Texture Eng::Texture::empty("[empty]");   
 
+   // Cache:
+   uint32_t Eng::Texture::cache[Eng::Texture::maxNrOfCachedUnits] = { 0 };
+
 
 
 /////////////////////////
@@ -41,16 +47,21 @@ struct Eng::Texture::Reserved
    std::reference_wrapper<const Eng::Bitmap> bitmap;
    Eng::Texture::Format format;
    glm::u32vec3 size;
+   uint32_t nrOfLevels;             ///< Number of mipmap levels allocated
    
    GLuint oglId;                    ///< OpenGL texture ID   
    GLuint64 oglBindlessHandle;      ///< GL_ARB_bindless_texture special handle
    GLuint oglInternalFormat;        ///< OpenGL internal format enum
 
 
+   // Allocated from a pool:
+   ENG_POOLED(Reserved)
+
+
    /**
     * Constructor. 
     */
-   Reserved() : bitmap{ Eng::Bitmap::empty }, format{ Eng::Texture::Format::none }, size{ 0, 0, 1 },
+   Reserved() : bitmap{ Eng::Bitmap::empty }, format{ Eng::Texture::Format::none }, size{ 0, 0, 1 }, nrOfLevels{ 1 },
                 oglId{ 0 }, oglBindlessHandle{ 0 }, oglInternalFormat{ 0 }
    {}
 };
@@ -226,6 +237,17 @@ void ENG_API Eng::Texture::setSizeZ(uint32_t sizeZ)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Get number of mipmap levels.
+ * @return number of levels
+ */
+uint32_t ENG_API Eng::Texture::getNrOfLevels() const
+{
+   return reserved->nrOfLevels;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Return the GLuint texture ID. 
@@ -266,7 +288,7 @@ bool ENG_API Eng::Texture::init()
    }
    if (reserved->oglId)   
    {
-	   glDeleteTextures(1, &reserved->oglId);
+	   Eng::Managed::release(Eng::Managed::Resource::texture, reserved->oglId);
       reserved->oglId = 0;
    }   
 
@@ -319,7 +341,10 @@ bool ENG_API Eng::Texture::free()
    }
    if (reserved->oglId)   
    {      
-	   glDeleteTextures(1, &reserved->oglId);
+      for (uint32_t c = 0; c < maxNrOfCachedUnits; c++)
+         if (Eng::Texture::cache[c] == reserved->oglId)
+            Eng::Texture::cache[c] = 0;
+	   Eng::Managed::release(Eng::Managed::Resource::texture, reserved->oglId);
       reserved->oglId = 0;
    }   
 
@@ -430,6 +455,24 @@ bool ENG_API Eng::Texture::load(const Eng::Bitmap &bitmap)
          _format        = Format::r8_compressed;
 		   break;	      
 
+      ///////////////////////////////////////////
+      case Eng::Bitmap::Format::r8g8b8a8_bptc: //
+         intFormat      = GL_COMPRESSED_RGBA_BPTC_UNORM;
+         extFormat      = GL_RGBA;
+         extType        = GL_UNSIGNED_BYTE;
+         nrOfComponents = 4;
+         _format        = Format::r8g8b8a8_bptc;
+         break;
+
+      /////////////////////////////////////////////
+      case Eng::Bitmap::Format::r16g16b16f_bptc: //
+         intFormat      = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+         extFormat      = GL_RGB;
+         extType        = GL_HALF_FLOAT;
+         nrOfComponents = 3;
+         _format        = Format::r16g16b16f_bptc;
+         break;
+
 		///////////
       default: //
          ENG_LOG_ERROR("Unexpected bitmap type");
@@ -442,6 +485,7 @@ bool ENG_API Eng::Texture::load(const Eng::Bitmap &bitmap)
 	// Create it:		              
    const GLuint oglId = this->getOglHandle();
    glBindTexture(GL_TEXTURE_2D, oglId);   
+   Eng::Texture::reset();
    if (bitmap.getNrOfLevels() > 1)
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, bitmap.getNrOfLevels());   
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -462,6 +506,8 @@ bool ENG_API Eng::Texture::load(const Eng::Bitmap &bitmap)
             case Format::r8g8b8_compressed:
             case Format::r8g8_compressed:
             case Format::r8_compressed:
+            case Format::r8g8b8a8_bptc:
+            case Format::r16g16b16f_bptc:
                glCompressedTexImage2D(GL_TEXTURE_2D, c, intFormat, bitmap.getSizeX(c), bitmap.getSizeY(c), 0, bitmap.getNrOfBytes(c), bitmap.getData(c));  
                break;
 
@@ -474,6 +520,15 @@ bool ENG_API Eng::Texture::load(const Eng::Bitmap &bitmap)
    if (bitmap.getNrOfLevels() <= 1)
       glGenerateMipmap(GL_TEXTURE_2D); 
 
+   // Account for the storage (generated mipmaps add about a third):
+   uint64_t nrOfBytes = 0;
+   for (uint32_t c = 0; c < bitmap.getNrOfLevels(); c++)
+      nrOfBytes += bitmap.getNrOfBytes(c);
+   nrOfBytes *= bitmap.getNrOfSides();
+   if (bitmap.getNrOfLevels() <= 1)
+      nrOfBytes += nrOfBytes / 3;
+   this->setMemoryUsage(MemoryType::texture, nrOfBytes);
+
    // Resident (if supported):
    if (Eng::Base::getInstance().isBindlessSupported())
       this->Eng::Texture::makeResident();
@@ -481,6 +536,7 @@ bool ENG_API Eng::Texture::load(const Eng::Bitmap &bitmap)
    // Done:   
    this->setBitmap(bitmap);
    this->setFormat(_format);
+   reserved->nrOfLevels = bitmap.getNrOfLevels();
    reserved->oglInternalFormat = intFormat;
    this->setSizeX(bitmap.getSizeX(0));
    this->setSizeY(bitmap.getSizeY(0));
@@ -494,9 +550,10 @@ bool ENG_API Eng::Texture::load(const Eng::Bitmap &bitmap)
  * @param sizeX texture width
  * @param sizeY texture height  
  * @param format pixel layout
+ * @param mipmaps when true, storage for the full mipmap chain is allocated
  * @return TF
  */	
-bool ENG_API Eng::Texture::create(uint32_t sizeX, uint32_t sizeY, Format format)
+bool ENG_API Eng::Texture::create(uint32_t sizeX, uint32_t sizeY, Format format, bool mipmaps)
 { 
 	// Safety net:
 	if (sizeX == 0 || sizeY == 0 || format == Format::none)
@@ -528,6 +585,14 @@ bool ENG_API Eng::Texture::create(uint32_t sizeX, uint32_t sizeY, Format format)
          nrOfComponents = 4;
 		   break;	      
 
+      /////////////////////
+      case Format::r32f: //
+         intFormat      = GL_R32F;
+         extFormat      = GL_RED;
+         extType        = GL_FLOAT;
+         nrOfComponents = 1;
+         break;
+
       //////////////////////
       case Format::depth: //
          intFormat = GL_DEPTH_COMPONENT24;
@@ -548,12 +613,23 @@ bool ENG_API Eng::Texture::create(uint32_t sizeX, uint32_t sizeY, Format format)
 	// Create it:		    
    const GLuint oglId = this->getOglHandle();
    glBindTexture(GL_TEXTURE_2D, oglId);   	      	
-   glTexImage2D(GL_TEXTURE_2D, 0, intFormat, sizeX, sizeY, 0, extFormat, extType, nullptr);         
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+   Eng::Texture::reset();
+   uint32_t nrOfLevels = 1;
+   if (mipmaps)
+      nrOfLevels = 1 + static_cast<uint32_t>(floor(log2(static_cast<double>(glm::max(sizeX, sizeY)))));
+   uint64_t nrOfBytes = 0;
+   const uint64_t texelSize = (extType == GL_FLOAT || format == Format::depth) ? 4 * nrOfComponents : nrOfComponents;
+   for (uint32_t c = 0; c < nrOfLevels; c++)
+   {
+      glTexImage2D(GL_TEXTURE_2D, c, intFormat, glm::max(1u, sizeX >> c), glm::max(1u, sizeY >> c), 0, extFormat, extType, nullptr);         
+      nrOfBytes += glm::max(1u, sizeX >> c) * glm::max(1u, sizeY >> c) * texelSize;
+   }
+   this->setMemoryUsage(MemoryType::texture, nrOfBytes);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);   
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); 
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);   
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);     
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, nrOfLevels - 1);     
    if (format == Format::depth)
    {
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -570,6 +646,7 @@ bool ENG_API Eng::Texture::create(uint32_t sizeX, uint32_t sizeY, Format format)
    	
 	// Done:
    this->setFormat(format);
+   reserved->nrOfLevels = nrOfLevels;
    reserved->oglInternalFormat = intFormat;
    this->setSizeX(sizeX);
    this->setSizeY(sizeY);
@@ -577,15 +654,28 @@ bool ENG_API Eng::Texture::create(uint32_t sizeX, uint32_t sizeY, Format format)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Forgets which textures are bound, forcing the next render() calls to rebind them. To be used after binding 
+ * textures without going through this class.
+ */
+void ENG_API Eng::Texture::reset()
+{
+   for (uint32_t c = 0; c < maxNrOfCachedUnits; c++)
+      Eng::Texture::cache[c] = 0;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  * Binds image for imagestore operations.
  * @param location location to bind the texture on 
+ * @param level mipmap level to bind
  * @return TF
  */
-bool ENG_API Eng::Texture::bindImage(uint32_t location)
+bool ENG_API Eng::Texture::bindImage(uint32_t location, uint32_t level)
 {     
-   glBindImageTexture(location, reserved->oglId, 0, GL_FALSE, 0, GL_READ_WRITE, reserved->oglInternalFormat);      
+   glBindImageTexture(location, reserved->oglId, level, GL_FALSE, 0, GL_READ_WRITE, reserved->oglInternalFormat);      
    return true;
 }
 
@@ -607,9 +697,14 @@ bool ENG_API Eng::Texture::render(uint32_t value, void *data) const
       std::string texLevel = "texture" + std::to_string(value);
       program.setUInt64(texLevel, this->getOglBindlessHandle());
    }
-   else // ...or old-school:
+   else // ...or old-school (only if necessary):
    {      
-      glBindTextures(value, 1, &reserved->oglId);
+      if (value >= maxNrOfCachedUnits || Eng::Texture::cache[value] != reserved->oglId)
+      {
+         glBindTextures(value, 1, &reserved->oglId);
+         if (value < maxNrOfCachedUnits)
+            Eng::Texture::cache[value] = reserved->oglId;
+      }
    }
 
    // Done:
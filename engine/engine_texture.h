@@ -19,6 +19,7 @@ public: //
 
    // Special values:
    static Texture empty;   
+   constexpr static uint32_t maxNrOfCachedUnits = 32;   ///< Number of texture units tracked to skip redundant binds
 
 
    /**
@@ -55,6 +56,11 @@ public: //
       r8g8b8_compressed,
       r8g8_compressed,
       r8_compressed,
+      r8g8b8a8_bptc,
+      r16g16b16f_bptc,
+
+      // Single channel float (e.g., Hi-Z pyramids):
+      r32f,
 
       // Depth maps:
       depth,
@@ -80,16 +86,18 @@ public: //
    uint32_t getSizeX() const;
    uint32_t getSizeY() const;
    uint32_t getSizeZ() const;   
+   uint32_t getNrOfLevels() const;
    uint32_t getOglHandle() const;
    uint64_t getOglBindlessHandle() const;
 
    // Bitmap:
    bool load(const Eng::Bitmap &bitmap);
-   bool create(uint32_t sizeX, uint32_t sizeY, Format format);
+   bool create(uint32_t sizeX, uint32_t sizeY, Format format, bool mipmaps = false);
 
    // Rendering methods:
    bool render(uint32_t value = 0, void *data = nullptr) const;
-   bool bindImage(uint32_t location = 0);
+   static void reset();
+   bool bindImage(uint32_t location = 0, uint32_t level = 0);
 
    // Managed:
    bool init() override;
@@ -116,6 +124,9 @@ private: //
 
    // Internal memory manager:   
    bool makeResident();
+
+   // Cache:
+   static uint32_t cache[maxNrOfCachedUnits];
 };
 
 
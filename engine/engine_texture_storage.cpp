@@ -10,6 +10,9 @@
 // #INCLUDE //
 //////////////
 
+// Logging subsystem:
+#define ENG_LOG_SUBSYSTEM texture
+
 // Main include:
 #include "engine.h"
 #include "engine_texture_storage.h"
@@ -161,7 +164,7 @@ bool ENG_API Eng::TextureStorage::init()
 
     if (reserved->oglId)
     {
-        glDeleteTextures(1, &reserved->oglId);
+        Eng::Managed::release(Eng::Managed::Resource::texture, reserved->oglId);
         reserved->oglId = 0;
     }
 
@@ -210,7 +213,7 @@ bool ENG_API Eng::TextureStorage::free()
 
     if (reserved->oglId)
     {
-        glDeleteTextures(1, &reserved->oglId);
+        Eng::Managed::release(Eng::Managed::Resource::texture, reserved->oglId);
         reserved->oglId = 0;
     }
 
@@ -248,7 +251,17 @@ bool ENG_API Eng::TextureStorage::create(uint32_t sizeX, uint32_t sizeY, GLenum
 
     const GLuint oglId = reserved->oglId;
     glBindTexture(GL_TEXTURE_2D, oglId);
+    Eng::Texture::reset();
     glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+
+    // Account for the storage (texel size of the formats used as image storage):
+    uint64_t texelSize = 4;
+    switch (format)
+    {
+    case GL_RG32UI: case GL_RG32F: case GL_RGBA16F: case GL_RGBA16UI: texelSize = 8; break;
+    case GL_RGBA32UI: case GL_RGBA32F: texelSize = 16; break;
+    }
+    this->setMemoryUsage(MemoryType::texture, static_cast<uint64_t>(width) * height * texelSize);
     glBindImageTexture(0, oglId, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
 
     // done
@@ -270,6 +283,7 @@ void Eng::TextureStorage::reset()
     std::vector<GLuint> initialData(width * height, initValue);
 
     glBindTexture(GL_TEXTURE_2D, reserved->oglId);
+    Eng::Texture::reset();
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED_INTEGER,
         GL_UNSIGNED_INT, initialData.data());
 }
@@ -288,6 +302,7 @@ bool ENG_API Eng::TextureStorage::render(uint32_t value, void* data) const
 
     glBindTextures(value, 1, &reserved->oglId);
     glBindImageTexture(value, reserved->oglId, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+    Eng::Texture::reset();
 
     // Done:
     return true;
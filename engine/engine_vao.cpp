@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM resource
+
    // Main include:
    #include "engine.h"
 
@@ -27,6 +30,9 @@
    // Special values:
    Eng::Vao Eng::Vao::empty("[empty]");
 
+   // Cache:
+   std::reference_wrapper<const Eng::Vao> Eng::Vao::cache = Eng::Vao::empty;
+
 
 
 /////////////////////////
@@ -121,8 +127,10 @@ bool ENG_API Eng::Vao::init()
    // Free buffer if already stored:
    if (reserved->oglId)
    {
-      glDeleteVertexArrays(1, &reserved->oglId);
+      Eng::Managed::release(Eng::Managed::Resource::vertexArray, reserved->oglId);
       reserved->oglId = 0;
+      if (Eng::Vao::cache.get() == *this)
+         Eng::Vao::cache = Eng::Vao::empty;
    }
 
    // Create it:		       
@@ -146,8 +154,10 @@ bool ENG_API Eng::Vao::free()
    // Free VAO if stored:
    if (reserved->oglId)
    {
-      glDeleteVertexArrays(1, &reserved->oglId);
+      Eng::Managed::release(Eng::Managed::Resource::vertexArray, reserved->oglId);
       reserved->oglId = 0;
+      if (Eng::Vao::cache.get() == *this)
+         Eng::Vao::cache = Eng::Vao::empty;
    }
 
    // Done:   
@@ -161,6 +171,7 @@ bool ENG_API Eng::Vao::free()
  */
 void ENG_API Eng::Vao::reset()
 {	   
+   Eng::Vao::cache = Eng::Vao::empty;
 	glBindVertexArray(0);
 }
 
@@ -174,7 +185,12 @@ void ENG_API Eng::Vao::reset()
  */
 bool ENG_API Eng::Vao::render(uint32_t value, void *data) const
 {	   
-   glBindVertexArray(reserved->oglId);
+   // Render only if necessary:
+   if (Eng::Vao::cache.get() != *this)
+   {
+      glBindVertexArray(reserved->oglId);
+      Eng::Vao::cache = *this;
+   }
    
    // Done:
    return true;
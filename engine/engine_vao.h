@@ -48,4 +48,7 @@ private: //
 
     // Const/dest:
     Vao(const std::string& name);
+
+    // Cache:
+    static std::reference_wrapper<const Eng::Vao> cache;
 };
@@ -11,6 +11,9 @@
 // #INCLUDE //
 //////////////
 
+   // Logging subsystem:
+   #define ENG_LOG_SUBSYSTEM resource
+
    // Main include:
    #include "engine.h"
 
@@ -133,7 +136,7 @@ bool ENG_API Eng::Vbo::init()
    // Free buffer if already stored:
    if (reserved->oglId)   
    {   
-	   glDeleteBuffers(1, &reserved->oglId);    
+	   Eng::Managed::release(Eng::Managed::Resource::buffer, reserved->oglId);    
       reserved->oglId = 0;   
       reserved->nrOfVertices = 0;
    }   
@@ -159,7 +162,7 @@ bool ENG_API Eng::Vbo::free()
    // Free VBO if stored:
    if (reserved->oglId)
    {
-      glDeleteBuffers(1, &reserved->oglId);
+      Eng::Managed::release(Eng::Managed::Resource::buffer, reserved->oglId);
       reserved->oglId = 0;
       reserved->nrOfVertices = 0;
    }
@@ -190,6 +193,7 @@ bool ENG_API Eng::Vbo::create(uint32_t nrOfVertices, const void *data)
    const GLuint oglId = this->getOglHandle();  
    glBindBuffer(GL_ARRAY_BUFFER, oglId);
    glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW); 
+   this->setMemoryUsage(MemoryType::vertexBuffer, size);
 
    // Setup interleaved-buffer:
    glBindVertexBuffer(0, oglId, 0, static_cast<GLsizei>(unitSize));   
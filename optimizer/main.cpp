@@ -0,0 +1,203 @@
+/**
+ * @file		main.cpp
+ * @brief	Offline OVO optimizer
+ *
+ * @author	Achille Peternier (achille.peternier@supsi.ch), (C) SUPSI
+ */
+
+
+
+//////////////
+// #INCLUDE //
+//////////////
+
+   // Main engine header:
+   #include "engine.h"
+
+   // C/C++:
+   #include <iostream>
+   #include <cstdlib>
+   #include <set>
+
+
+
+//////////
+// VARS //
+//////////
+
+   // Options:
+   uint32_t maxNrOfLods = 0xffffffff;     ///< Max number of LODs kept per mesh
+   float minReduction = 0.25f;            ///< Min face reduction of a LOD over the previous one to be kept
+   bool compress = false;                 ///< Compress the vertex and face streams
+
+
+
+///////////
+// UTILS //
+///////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Collects all the meshes of a scene graph.
+ * @param node current node
+ * @param meshes list filled with the meshes found
+ */
+void collectMeshes(Eng::Node &node, std::vector<std::reference_wrapper<Eng::Mesh>> &meshes)
+{
+   Eng::Mesh *mesh = dynamic_cast<Eng::Mesh *>(&node);
+   if (mesh)
+      meshes.push_back(*mesh);
+   for (auto &child : node.getListOfChildren())
+      collectMeshes(child, meshes);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Tells whether two materials look identical (same PBR props and same textures).
+ * @param a first material
+ * @param b second material
+ * @return TF
+ */
+bool isSameMaterial(const Eng::Material &a, const Eng::Material &b)
+{
+   if (a.getEmission() != b.getEmission() || a.getAlbedo() != b.getAlbedo() || a.getOpacity() != b.getOpacity() ||
+       a.getRoughness() != b.getRoughness() || a.getMetalness() != b.getMetalness())
+      return false;
+
+   for (Eng::Texture::Type type : { Eng::Texture::Type::albedo, Eng::Texture::Type::normal,
+                                    Eng::Texture::Type::roughness, Eng::Texture::Type::metalness })
+      if (a.getTexture(type).getName() != b.getTexture(type).getName())
+         return false;
+   return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Gets the number of LODs worth keeping: a LOD is dropped (along with all the following ones) when it does not
+ * reduce the number of faces of the previous one by at least minReduction.
+ * @param mesh mesh
+ * @return number of LODs to keep
+ */
+uint32_t getNrOfUsefulLods(const Eng::Mesh &mesh)
+{
+   uint32_t nrOfLods = 1;
+   while (nrOfLods < mesh.getNrOfLods() && nrOfLods < maxNrOfLods &&
+          mesh.getNrOfFaces(nrOfLods) <= (1.0f - minReduction) * mesh.getNrOfFaces(nrOfLods - 1))
+      nrOfLods++;
+   return nrOfLods;
+}
+
+
+
+//////////
+// MAIN //
+//////////
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ * Application entry point.
+ * @param argc number of command-line arguments passed
+ * @param argv array containing up to argc passed arguments
+ * @return error code (0 on success, error code otherwise)
+ */
+int main(int argc, char *argv[])
+{
+   // Credits:
+   std::cout << "OVO optimizer, A. Peternier (C) SUPSI" << std::endl;
+   std::cout << std::endl;
+
+   // Options:
+   if (argc < 3)
+   {
+      std::cout << "Usage: " << argv[0] << " <input.ovo> <output.ovo> [--max-lods N] [--min-reduction F] [--compress]" << std::endl;
+      return 1;
+   }
+   const std::string input = argv[1], output = argv[2];
+   for (int32_t c = 3; c < argc; c++)
+   {
+      const std::string option = argv[c];
+      if (option == "--max-lods" && c + 1 < argc)
+         maxNrOfLods = std::max(1, atoi(argv[++c]));
+      else if (option == "--min-reduction" && c + 1 < argc)
+         minReduction = static_cast<float>(atof(argv[++c]));
+      else if (option == "--compress")
+         compress = true;
+      else
+      {
+         std::cout << "Unknown option: " << option << std::endl;
+         return 1;
+      }
+   }
+
+   // No context is created: geometries and textures are never uploaded, so a CPU copy must be kept:
+   Eng::Mesh::setKeepGeometry(true);
+
+
+   /////////////////
+   // Loading scene (meshes are optimized for the vertex cache, overdraw and vertex fetch while loading):
+   Eng::Ovo ovo;
+   Eng::Node &root = ovo.load(input, false);
+   if (root == Eng::Node::empty)
+   {
+      std::cout << "Unable to load '" << input << "'" << std::endl;
+      return 2;
+   }
+
+   std::vector<std::reference_wrapper<Eng::Mesh>> meshes;
+   collectMeshes(root, meshes);
+
+   // Identical materials are merged into the first one (unused ones are not saved):
+   std::vector<std::reference_wrapper<const Eng::Material>> materials;
+   uint32_t nrOfMergedMaterials = 0;
+   for (Eng::Mesh &mesh : meshes)
+   {
+      const Eng::Material &material = mesh.getMaterial();
+      if (material == Eng::Material::empty)
+         continue;
+
+      bool found = false;
+      for (const Eng::Material &other : materials)
+         if (isSameMaterial(material, other))
+         {
+            if (other != material)
+               nrOfMergedMaterials++;
+            mesh.setMaterial(other);
+            found = true;
+            break;
+         }
+      if (!found)
+         materials.push_back(material);
+   }
+
+   // LODs and bounds:
+   uint32_t nrOfStrippedLods = 0;
+   std::set<uint32_t> geometries;
+   for (Eng::Mesh &mesh : meshes)
+   {
+      const uint32_t nrOfLods = mesh.getNrOfLods();
+      if (nrOfLods == 0)
+         continue;
+      if (mesh.stripLods(getNrOfUsefulLods(mesh)))
+         nrOfStrippedLods += nrOfLods - mesh.getNrOfLods();
+      mesh.updateBounds();
+      geometries.insert(mesh.getGeometryId());
+   }
+
+   // Save:
+   if (!ovo.save(output, root, compress))
+   {
+      std::cout << "Unable to save '" << output << "'" << std::endl;
+      return 3;
+   }
+
+   // Stats:
+   std::cout << "Meshes: " << meshes.size() << ", distinct geometries: " << geometries.size() << std::endl;
+   std::cout << "Materials: " << materials.size() << " (" << nrOfMergedMaterials << " references merged)" << std::endl;
+   std::cout << "LODs stripped: " << nrOfStrippedLods << std::endl;
+
+   // Done:
+   std::cout << "[application terminated]" << std::endl;
+   return 0;
+}